@@ -0,0 +1,1190 @@
+/*
+Game state machine - the game as driven by input, shared by ThreeMensMorris.cpp and tools/Fuzz.cpp
+
+handleEvent() applies one input event and updateTokens() moves the tokens
+that are on their way to a slot; together they take the game through its
+phases. Nothing here opens a window or needs the textures to be loaded, so
+the same code runs headless under the fuzzer.
+
+The board is loaded from a description in boards/ (boards/three.txt by default).
+Slots are the points of that description; adjacency and mills are compiled into
+bitmask tables so that move checks and mill detection work on any Morris board.
+Tokens live in fixed storage (TokenStore) under stable handles, with masks of
+the slots they hold; a token there is only its game state, in 8 bytes. What is
+drawn for it (position and sprite) is kept apart, by handle, in tokenSprites.
+Clicks find their slot through a SlotGrid and the slot masks, in constant time
+on any board.
+The same lookup finds the slot under the pointer for hover highlighting
+(Highlights), which is recomputed only when the state changes.
+
+Tokens are animated by tweens (Tween.hpp): a move eases to its slot at about the
+old constant speed and lands when its tween finishes, placed tokens drop in,
+and closed mills flash. Only the landing of a move changes the game state.
+
+The hint button (or H) shows the best move for the side to move: probed from
+the compile-time Three Men's Morris table on that board, within the frame, or
+else searched for on a worker thread (engine/Search.hpp) for at most half a
+second, while the game keeps drawing (pollHint()).
+
+Every placement, move and removal is kept as a 16-bit GameDelta in undoHistory.
+undoStep() takes the last one back in constant time, from the delta and the
+current state alone (a taken-back move slides its token home), and redoStep()
+plays it again through the same code as a click.
+
+Each position is submitted to the analyzer (engine/Analysis.hpp) as the turn
+passes, so the review of the game (gameReview) is ready on the win screen;
+E exports it as text.
+
+Started with a puzzle pack (tools/Puzzles.cpp), each game is a puzzle set up
+on the board (startPuzzle()): the start button sets up the next one and the
+reset button the same one again.
+
+Sessions can be recorded as the input events of each frame and played back
+through handleEvent() with the same fixed frame time (Recording), ending on
+the same stateHash(). selfPlayClick() plays the game with random legal moves
+through the same clicks, for headless workloads.
+*/
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <iomanip>
+#include <random>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include <SFML/Graphics.hpp>
+#include "engine/Morris.hpp"
+#include "engine/SlotGrid.hpp"
+#include "engine/CompileTimeSolve.hpp"
+#include "engine/Search.hpp"
+#include "engine/Analysis.hpp"
+#include "Tween.hpp"
+
+inline std::ofstream logFile("game.log");
+
+inline Topology topology; // Board description: slot positions, edges, mills and rules
+inline Rules32 rules;     // Bitmask tables compiled from the topology
+inline SlotGrid slotGrid; // Slot lookup by board position
+
+enum class GamePhase { Start, About, Instructions, Placement, Movement, Win }; // Enum to represent game phases
+
+constexpr float kTokenSize = 50.f;  // Tokens are drawn as 50x50 sprites centred on their slot
+constexpr float kTokenSpeed = 400.f; // Average speed of a moving token, in pixels per second
+
+// Token structure to represent each player's token in the game (see TokenSprites for drawing)
+struct Token {
+    Player owner = Player::A;   // Which player owns this token (Player::A or Player::B)
+    int8_t slotIndex = -1;      // Current slot index where this token is placed (-1 if not placed)
+    int8_t nextSlotIndex = -1;  // The next slot index where the token will move (-1 if no move scheduled)
+    bool selected = false;      // Is this token currently selected by the player?
+    bool moving = false;        // Is the token currently in motion (moving to nextSlotIndex)?
+};
+
+// The tokens of a game in fixed storage. A token's handle is the order it was placed
+// in, so it stays valid until the token is removed, nothing is allocated during a game,
+// and tokens are visited in placement order. Tokens are found by slot through bySlot
+// and the slot masks, which follow every change.
+struct TokenStore {
+    static constexpr int kCapacity = Rules32::kMaxPoints; // Boards hold at most this many tokens
+
+    std::array<Token, kCapacity> items;
+    uint32_t used = 0;                    // Live handles
+    int placed = 0;                       // Handles given out this game
+    std::array<int8_t, kCapacity> bySlot; // Token on each slot (a moving token's is the one it left), or -1
+    std::array<uint32_t, 2> men{};        // Slots of each player's tokens, as in bySlot
+    uint32_t occupied = 0;                // Slots holding a token or awaiting a moving one
+
+    TokenStore() { bySlot.fill(-1); }
+
+    template <typename T>
+    struct Iterator { // Visits the live tokens in handle order
+        T* items;
+        uint32_t rest;
+        T& operator*() const { return items[lowestPoint(rest)]; }
+        Iterator& operator++() { rest &= rest - 1; return *this; }
+        bool operator!=(const Iterator& other) const { return rest != other.rest; }
+    };
+    Iterator<Token> begin() { return {items.data(), used}; }
+    Iterator<Token> end() { return {items.data(), 0}; }
+    Iterator<const Token> begin() const { return {items.data(), used}; }
+    Iterator<const Token> end() const { return {items.data(), 0}; }
+
+    Token& operator[](int handle) { return items[handle]; }
+    const Token& operator[](int handle) const { return items[handle]; }
+    bool live(int handle) const { return handle >= 0 && handle < kCapacity && (used >> handle & 1u); }
+    int size() const { return countMen(used); }
+    bool empty() const { return used == 0; }
+
+    // Places a token on t.slotIndex; returns its handle
+    int add(const Token& t) {
+        int h = placed++;
+        items[h] = t;
+        used |= 1u << h;
+        bySlot[t.slotIndex] = static_cast<int8_t>(h);
+        men[static_cast<int>(t.owner)] |= 1u << t.slotIndex;
+        occupied |= 1u << t.slotIndex;
+        return h;
+    }
+
+    // Puts a removed token back under its old handle
+    void restore(int handle, const Token& t) {
+        items[handle] = t;
+        used |= 1u << handle;
+        bySlot[t.slotIndex] = static_cast<int8_t>(handle);
+        men[static_cast<int>(t.owner)] |= 1u << t.slotIndex;
+        occupied |= 1u << t.slotIndex;
+    }
+
+    // Takes back the last token added; the next add() gives its handle out again
+    void removeLast() {
+        remove(placed - 1);
+        --placed;
+    }
+
+    // Puts a token that is not moving straight onto the free 'slot'
+    void relocate(int handle, int slot) {
+        Token& t = items[handle];
+        uint32_t from = 1u << t.slotIndex, to = 1u << slot;
+        bySlot[t.slotIndex] = -1;
+        bySlot[slot] = static_cast<int8_t>(handle);
+        men[static_cast<int>(t.owner)] ^= from | to;
+        occupied ^= from | to;
+        t.slotIndex = static_cast<int8_t>(slot);
+    }
+
+    void remove(int handle) {
+        const Token& t = items[handle];
+        used &= ~(1u << handle);
+        bySlot[t.slotIndex] = -1;
+        men[static_cast<int>(t.owner)] &= ~(1u << t.slotIndex);
+        occupied &= ~(1u << t.slotIndex);
+    }
+
+    // Sets a token moving to 'slot', which it holds from now on
+    void startMove(int handle, int slot) {
+        items[handle].moving = true;
+        items[handle].nextSlotIndex = slot;
+        occupied |= 1u << slot;
+    }
+
+    // Ends the move of a token: it leaves its slot for the one it was moving to
+    void land(int handle) {
+        Token& t = items[handle];
+        uint32_t from = 1u << t.slotIndex, to = 1u << t.nextSlotIndex;
+        bySlot[t.slotIndex] = -1;
+        bySlot[t.nextSlotIndex] = static_cast<int8_t>(handle);
+        men[static_cast<int>(t.owner)] ^= from | to;
+        occupied &= ~from;
+        t.slotIndex = t.nextSlotIndex;
+        t.nextSlotIndex = -1;
+        t.moving = false;
+    }
+
+    void clear() {
+        used = 0;
+        placed = 0;
+        bySlot.fill(-1);
+        men = {};
+        occupied = 0;
+    }
+};
+
+// How the tokens are drawn, by handle: the top-left corner of each token's sprite, where
+// its animation has it, and the sprite it is drawn with (its owner's token texture).
+struct TokenSprites {
+    std::array<sf::Vector2f, TokenStore::kCapacity> position;
+    std::array<uint8_t, TokenStore::kCapacity> sprite{};
+};
+
+inline TokenSprites tokenSprites;
+
+// One step of a game, as undo and redo need it, in 16 bits: the kind and two 5-bit
+// fields. A placement keeps its slot, a move the slot it left and the one it reached,
+// and a removal the slot and handle of the token taken and whether it was taken during
+// placement. The rest (whose step it was, which token moved) follows from the state.
+struct GameDelta {
+    enum Kind : uint8_t { Place, Move, Remove };
+    uint16_t bits = 0;
+
+    static GameDelta make(Kind kind, int slot, int other = 0, bool placing = false) {
+        return {static_cast<uint16_t>(kind | slot << 2 | other << 7 | placing << 12)};
+    }
+    Kind kind() const { return static_cast<Kind>(bits & 3); }
+    int slot() const { return bits >> 2 & 31; }
+    int to() const { return bits >> 7 & 31; }     // Of a move
+    int handle() const { return bits >> 7 & 31; } // Of a removal
+    bool placing() const { return bits >> 12 & 1; }
+};
+
+// The steps of the current game: the first 'done' were played, the rest were undone and
+// can be redone until a new step is played
+struct UndoHistory {
+    std::vector<GameDelta> deltas;
+    std::size_t done = 0;
+
+    void record(GameDelta d) {
+        deltas.resize(done);
+        deltas.push_back(d);
+        ++done;
+    }
+    void clear() {
+        deltas.clear();
+        done = 0;
+    }
+};
+
+inline UndoHistory undoHistory;
+
+inline std::unordered_map<std::string, sf::Sprite> spritesMap; // Map to hold sprites by name
+inline sf::FloatRect startButtonBounds(165, 440, 275, 100); // Bounds for the start button
+inline sf::FloatRect instructionsButtonBounds(165, 560, 275, 100); // Bounds for the instructions button
+inline sf::FloatRect aboutButtonBounds(165, 680, 275, 100); // Bounds for the about button
+inline sf::FloatRect exitButtonBounds(165, 650, 275, 100); // Bounds for the exit button
+
+// What the board highlights: the slots a click acts on (free slots when placing, own
+// tokens and the selected token's destinations when moving, or the tokens that may be
+// taken), the selected token's legal destinations, the target under the pointer, and
+// the hinted move. Targets change with the game state only; pointer moves just look up
+// 'hover'.
+struct Highlights {
+    uint32_t targets = 0;
+    uint32_t destinations = 0;
+    int hover = -1;
+    sf::Vector2f pointer{-1, -1}; // Last pointer position, in board coordinates
+    Move hint;                    // to == -1 if none; only 'remove' once the move is made
+};
+inline Highlights highlights;
+
+// The best move for a position, asked for with the hint button or H. It is shown while
+// the board is in that position (tokens, tokens placed and side to move), and its
+// removal once its move is made.
+struct Hint {
+    std::array<uint32_t, 2> men{};
+    int placed = -1;
+    Player turn = Player::A;
+    Move move;
+    bool searching = false; // Waiting for hintSearch
+    bool ready = false;
+};
+inline Hint hint;
+inline bool hintFromTable = false;              // The board is Three Men's Morris, solved in kThreeMensMorrisTable
+inline BackgroundSearch<uint32_t> hintSearch(rules); // Hints on the other boards
+constexpr double kHintSeconds = 0.5;            // Longest a hint search runs
+inline sf::FloatRect hintButtonBounds(159, 562, 32, 32); // Below the board, between its bottom points
+
+// A position where the side to move wins in 'value' plies, and only by 'solution'
+struct Puzzle {
+    Position32 position;
+    uint8_t value = kUnknown;
+    Move solution;
+};
+
+// Puzzles mined by tools/Puzzles.cpp. The file has a "board <path>" line and a line per
+// puzzle, "puzzle <turn A|B> <men A> <men B> <hand A> <hand B> <value> <solution>", with
+// the men as hex slot masks and the solution as moveName() writes it.
+struct PuzzlePack {
+    std::string board;
+    std::vector<Puzzle> puzzles;
+    std::size_t current = 0, next = 0; // The puzzle in play (a reset sets it up again) and the next one
+};
+inline PuzzlePack puzzlePack; // Empty unless the game was started with --puzzles: games are then puzzles
+
+// The review of the game being played (engine/Analysis.hpp). Each position is submitted to
+// the analyzer as the turn passes: valued from the Three Men's Morris table at once, or
+// searched on worker threads while the game goes on, so that the review is ready by the
+// win screen, where updateReview() finishes it.
+struct GameReview {
+    Position32 start;               // An empty board, or the puzzle the game began from
+    std::vector<Move> moves;        // As played, from undoHistory
+    std::vector<MoveReview> review; // One per move, once ready
+    std::string text;               // gameReport()
+    bool ready = false;
+};
+inline GameReview gameReview;
+inline bool analyzeGames = false;         // Set for the game window, not for playback or self-play
+constexpr double kAnalysisSeconds = 0.25; // Longest search per position
+inline PositionAnalyzer<uint32_t> analyzer(rules, std::clamp(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1, 4),
+                                           kAnalysisSeconds);
+
+// What the tweens animate. The key of a move, a drop or a slide back is the token's
+// handle, and of a mill flash the mask of the mills. A slide back (TweenUndo) takes
+// the sprite of a taken-back move home; unlike a move, nothing lands when it ends.
+enum TweenKind : uint8_t { TweenMove, TweenDrop, TweenMill, TweenUndo };
+
+// Running animations: one per token at most (see stopTokenTweens()), and a mill flash
+inline TweenPool<TokenStore::kCapacity + 2> tweens;
+
+// Stops the drop or slide back of a token, before it moves, is removed or drops again
+inline void stopTokenTweens(int handle) {
+    tweens.cancel(TweenDrop, handle);
+    tweens.cancel(TweenUndo, handle);
+}
+
+// Function to log messages to a file with timestamps
+inline void log(std::string_view message) {
+    std::time_t now = std::time(nullptr);
+    std::tm* localTime = std::localtime(&now);
+    logFile << "[" << std::put_time(localTime, "%a %b %d %H:%M:%S %Y") << "] - " << message << std::endl;
+}
+
+// Takes hints and the game analysis from the compile-time table on Three Men's Morris,
+// and from searches on any other board
+inline void useTables() {
+    hintFromTable = isThreeMensMorris(rules);
+    analyzer.setProbe(hintFromTable ? PositionAnalyzer<uint32_t>::Probe(probeThreeMensMorris<uint32_t>) : nullptr);
+}
+
+// Function to load the board description and compile its rule tables
+inline bool loadBoard(const std::string& path) {
+    std::string error;
+    if (!loadTopology(path, topology, error) || !compileTopology(topology, rules, error)) {
+        log("Failed to load board: " + error);
+        return false;
+    }
+    slotGrid.build(topology, kTokenSize);
+    useTables();
+    log("Loaded board " + topology.name + " from " + path + ".");
+    return true;
+}
+
+// Window position of a slot (the centre of the board point)
+inline sf::Vector2f slotPosition(int slot) {
+    return sf::Vector2f(topology.points[slot].x, topology.points[slot].y);
+}
+
+// Builds the engine position for the tokens on the board
+inline Position32 boardPosition(const TokenStore& tokens, int placedA, int placedB, Player turn) {
+    Position32 pos;
+    pos.men = tokens.men;
+    pos.hand = {rules.men - placedA, rules.men - placedB};
+    pos.turn = turn;
+    return pos;
+}
+
+// Returns the index of the unoccupied slot under the mouse, or -1 if none.
+inline int getFreeSlotUnderMouse(const sf::Vector2f& pos, const TokenStore& tokens) {
+    return slotGrid.pointAt(pos.x, pos.y, rules.full & ~tokens.occupied);
+}
+
+// Recomputes the highlights for a new game state (see Highlights)
+inline void refreshHighlights(
+    const TokenStore& tokens,
+    Player turn,
+    GamePhase phase,
+    int selected,
+    bool removing)
+{
+    highlights.targets = highlights.destinations = 0;
+    Position32 pos;
+    pos.turn = turn;
+    pos.men = tokens.men;
+    if (selected != -1 && tokens[selected].moving) {
+        // Clicks wait until the token lands
+    } else if (removing) {
+        highlights.targets = removableMen(rules, pos.men[1 - static_cast<int>(turn)]);
+    } else if (phase == GamePhase::Placement) {
+        highlights.targets = rules.full & ~tokens.occupied;
+    } else if (phase == GamePhase::Movement) {
+        if (selected != -1) highlights.destinations = destinations(rules, pos, tokens[selected].slotIndex);
+        highlights.targets = pos.men[static_cast<int>(turn)] | highlights.destinations;
+    }
+    highlights.hover = slotGrid.pointAt(highlights.pointer.x, highlights.pointer.y, highlights.targets);
+
+    highlights.hint = Move();
+    bool inPlay = phase == GamePhase::Placement || phase == GamePhase::Movement;
+    if (!hint.ready || !inPlay || hint.turn != turn || (selected != -1 && tokens[selected].moving)) return;
+    int me = static_cast<int>(turn);
+    uint32_t moved = (hint.men[me] & ~(hint.move.from >= 0 ? 1u << hint.move.from : 0u)) | 1u << hint.move.to;
+    if (!removing && tokens.placed == hint.placed && tokens.men == hint.men)
+        highlights.hint = hint.move;
+    else if (removing && hint.move.remove >= 0 && tokens.men[me] == moved && tokens.men[1 - me] == hint.men[1 - me] &&
+             tokens.placed == hint.placed + (hint.move.from < 0 ? 1 : 0))
+        highlights.hint.remove = hint.move.remove;
+}
+
+// Asks for a hint for the side to move, unless it is removing a token or a token is
+// moving. On Three Men's Morris the hint is ready at once; elsewhere a search starts and
+// pollHint() takes in its result. Requests go to game.log as "hint" lines of key=value
+// fields.
+inline void requestHint(
+    const TokenStore& tokens,
+    Player turn,
+    GamePhase phase,
+    int placedA, int placedB,
+    int selected,
+    bool removing)
+{
+    bool inPlay = phase == GamePhase::Placement || phase == GamePhase::Movement;
+    if (!inPlay || removing || (selected != -1 && tokens[selected].moving)) return;
+    if ((hint.ready || hint.searching) && hint.turn == turn && hint.placed == tokens.placed && hint.men == tokens.men)
+        return; // Already asked for
+    hint = Hint();
+    hint.men = tokens.men;
+    hint.placed = tokens.placed;
+    hint.turn = turn;
+    Position32 pos = boardPosition(tokens, placedA, placedB, turn);
+    char line[256];
+    int n = std::snprintf(line, sizeof line, "hint board=\"%s\" phase=%s turn=%c", topology.name.c_str(),
+                          phase == GamePhase::Placement ? "placement" : "movement", turn == Player::A ? 'A' : 'B');
+    if (hintFromTable) {
+        auto begin = std::chrono::steady_clock::now();
+        uint8_t value = kUnknown;
+        hint.move = tableMove(rules, pos, [](const Position32& p) { return probeThreeMensMorris(p); }, &value);
+        hint.ready = hint.move.to >= 0;
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+        std::snprintf(line + n, sizeof line - n, " source=table move=%s value=\"%s\" us=%.1f",
+                      moveName(hint.move).c_str(), valueName(value).c_str(), us);
+    } else {
+        SearchLimits limits;
+        limits.seconds = kHintSeconds;
+        hintSearch.start(pos, limits);
+        hint.searching = true;
+        std::snprintf(line + n, sizeof line - n, " source=search status=started");
+    }
+    log(line);
+}
+
+// Takes in the result of a hint search once it is in. Called every frame; never waits.
+inline void pollHint(
+    const TokenStore& tokens,
+    Player turn,
+    GamePhase phase,
+    int selected,
+    bool removing)
+{
+    SearchResult result;
+    if (!hint.searching || !hintSearch.poll(result)) return;
+    hint.searching = false;
+    hint.move = result.best;
+    hint.ready = result.best.to >= 0;
+    char line[256];
+    std::snprintf(line, sizeof line, "hint source=search status=done turn=%c move=%s score=%s depth=%d nodes=%llu ms=%.1f",
+                  hint.turn == Player::A ? 'A' : 'B', moveName(result.best).c_str(), scoreName(result.score).c_str(),
+                  result.depth, static_cast<unsigned long long>(result.nodes), result.seconds * 1000);
+    log(line);
+    refreshHighlights(tokens, turn, phase, selected, removing);
+}
+
+// Submits a position of the game being played for its review
+inline void analyzePosition(const Position32& pos) {
+    if (analyzeGames) analyzer.submit(pos);
+}
+
+// Starts the review of a game played from 'start', forgetting the last one
+inline void beginReview(const Position32& start) {
+    analyzer.clear();
+    gameReview = GameReview();
+    gameReview.start = start;
+    analyzePosition(start);
+}
+
+// The moves played so far, from undoHistory: a removal is part of the move before it
+inline std::vector<Move> playedMoves() {
+    std::vector<Move> moves;
+    for (std::size_t i = 0; i < undoHistory.done; ++i) {
+        GameDelta d = undoHistory.deltas[i];
+        Move m;
+        if (d.kind() == GameDelta::Remove) {
+            moves.back().remove = static_cast<int8_t>(d.slot());
+            continue;
+        }
+        if (d.kind() == GameDelta::Move) m.from = static_cast<int8_t>(d.slot());
+        m.to = static_cast<int8_t>(d.kind() == GameDelta::Move ? d.to() : d.slot());
+        moves.push_back(m);
+    }
+    return moves;
+}
+
+// Finishes the review of a won game once all its positions are analyzed, and logs it.
+// Called when the game is won and then every frame until it is ready.
+inline void updateReview(GamePhase phase) {
+    if (phase != GamePhase::Win || gameReview.ready || !analyzeGames) return;
+    gameReview.moves = playedMoves();
+    if (!reviewGame(rules, analyzer, gameReview.start, gameReview.moves, gameReview.review)) return;
+    gameReview.text = gameReport(topology, gameReview.start, gameReview.moves, gameReview.review);
+    gameReview.ready = true;
+    log("Game analysis:\n" + gameReview.text);
+}
+
+// Writes the review of the won game to a text file (E on the win screen)
+inline void exportReview(const std::string& path) {
+    if (!gameReview.ready) return;
+    std::ofstream out(path);
+    out << gameReview.text;
+    log(out ? "Game analysis written to " + path + "." : "Failed to write the game analysis to " + path + ".");
+}
+
+// Shows the turn indicator for the player to move in the current phase
+inline void showTurnIndicator(Player turn, GamePhase phase) {
+    if (phase == GamePhase::Placement)
+        spritesMap["currentPTI"] = spritesMap[turn == Player::A ? "papt" : "pbpt"];
+    else
+        spritesMap["currentPTI"] = spritesMap[turn == Player::A ? "pamt" : "pbmt"];
+}
+
+// Ends the game in favour of 'winner'
+inline void declareWinner(Player winner, GamePhase& phase) {
+    log(winner == Player::A ? "Player A wins!" : "Player B wins!");
+    spritesMap["winner"] = spritesMap[winner == Player::A ? "winA" : "winB"];
+    phase = GamePhase::Win;
+    startButtonBounds = sf::FloatRect(165, 510, 275, 100);
+    updateReview(phase);
+}
+
+// Passes the turn to the opponent, entering the movement phase once all tokens are placed.
+// The game ends if the new player to move has lost (too few tokens) or is blocked.
+inline void endTurn(
+    const TokenStore& tokens,
+    int placedA, int placedB,
+    Player& turn,
+    GamePhase& phase)
+{
+    turn = opponent(turn);
+    if (phase == GamePhase::Placement && placedA == rules.men && placedB == rules.men)
+        phase = GamePhase::Movement;
+    showTurnIndicator(turn, phase);
+
+    Position32 pos = boardPosition(tokens, placedA, placedB, turn);
+    if (isGameOver(rules, pos)) declareWinner(opponent(turn), phase);
+    else analyzePosition(pos);
+}
+
+// Called when a token of 'turn' lands on 'slot'. Closing a mill either wins the game
+// or lets the player remove an opponent token, depending on the board's capture rule.
+inline void finishMove(
+    const TokenStore& tokens,
+    int slot,
+    int placedA, int placedB,
+    Player& turn,
+    GamePhase& phase,
+    bool& removing)
+{
+    Position32 pos = boardPosition(tokens, placedA, placedB, turn);
+    uint32_t mills = 0; // The mills through 'slot' the token closed
+    for (int i = 0; i < rules.millCountAt[slot]; ++i)
+        if ((pos.men[static_cast<int>(turn)] & rules.millsAt[slot][i]) == rules.millsAt[slot][i])
+            mills |= rules.millsAt[slot][i];
+    if (mills) {
+        // The mill flashes; a winning one long enough to be seen before the win screen
+        tweens.cancel(TweenMill);
+        bool wins = rules.capture == CaptureRule::Win;
+        tweens.start(TweenMill, static_cast<int>(mills), 0, 0, 1, 0, wins ? 1.2f : 0.6f, Ease::Linear);
+        if (wins) {
+            declareWinner(turn, phase);
+            return;
+        }
+        removing = true;
+        log(turn == Player::A ? "Player A closed a mill." : "Player B closed a mill.");
+        return;
+    }
+    endTurn(tokens, placedA, placedB, turn, phase);
+}
+
+// Sets up puzzle 'index' of puzzlePack on a cleared board, as a game in play
+inline void startPuzzle(
+    std::size_t index,
+    TokenStore& tokens,
+    int& placedA, int& placedB,
+    Player& turn,
+    GamePhase& phase)
+{
+    const Puzzle& puzzle = puzzlePack.puzzles[index];
+    puzzlePack.current = index;
+    puzzlePack.next = (index + 1) % puzzlePack.puzzles.size();
+    for (int p = 0; p < 2; ++p)
+        for (uint32_t m = puzzle.position.men[p]; m; m &= m - 1) {
+            Token t;
+            t.owner = static_cast<Player>(p);
+            t.slotIndex = static_cast<int8_t>(lowestPoint(m));
+            int h = tokens.add(t);
+            tokenSprites.position[h] = slotPosition(t.slotIndex) - sf::Vector2f(25, 25);
+            tokenSprites.sprite[h] = static_cast<uint8_t>(p);
+        }
+    placedA = rules.men - puzzle.position.hand[0];
+    placedB = rules.men - puzzle.position.hand[1];
+    tokens.placed = placedA + placedB; // The handles of the tokens taken before the puzzle stay unused
+    turn = puzzle.position.turn;
+    phase = placedA == rules.men && placedB == rules.men ? GamePhase::Movement : GamePhase::Placement;
+    showTurnIndicator(turn, phase);
+    beginReview(puzzle.position);
+    log("Puzzle " + std::to_string(index + 1) + " of " + std::to_string(puzzlePack.puzzles.size()) + ": Player " +
+        (turn == Player::A ? "A" : "B") + " to move and " + valueName(puzzle.value) + ".");
+}
+
+// Resets the game state
+inline void resetGame(
+    TokenStore& tokens,
+    int& placedA, int& placedB,
+    Player& turn,
+    GamePhase& phase,
+    int& selected,
+    bool& removing)
+{
+    if (phase == GamePhase::Win) {
+        phase = GamePhase::Start;
+        startButtonBounds = sf::FloatRect(165, 440, 275, 100);
+    } else {
+        phase = GamePhase::Placement;
+        startButtonBounds = sf::FloatRect(340, 620, 240, 80);
+        log("Game reset.");
+    }
+    tokens.clear();
+    tweens.clear();
+    undoHistory.clear();
+    hintSearch.cancel();
+    hint = Hint();
+    placedA = placedB = 0;
+    turn = Player::A;
+    selected = -1;
+    removing = false;
+    spritesMap["currentPTI"] = spritesMap["papt"];
+    beginReview(boardPosition(tokens, placedA, placedB, turn));
+    if (phase == GamePhase::Placement && !puzzlePack.puzzles.empty())
+        startPuzzle(puzzlePack.current, tokens, placedA, placedB, turn, phase);
+    refreshHighlights(tokens, turn, phase, selected, removing);
+}
+
+// Places a token of 'turn' on the free 'slot'; it drops in
+inline void placeToken(
+    int slot,
+    TokenStore& tokens,
+    int& placedA, int& placedB,
+    Player& turn,
+    GamePhase& phase,
+    bool& removing)
+{
+    Token t;
+    t.owner = turn;
+    t.slotIndex = static_cast<int8_t>(slot);
+    sf::Vector2f at = slotPosition(slot) - sf::Vector2f(25, 25);
+    int h = tokens.add(t);
+    tokenSprites.position[h] = at - sf::Vector2f(0, 30);
+    tokenSprites.sprite[h] = static_cast<uint8_t>(turn);
+    tweens.start(TweenDrop, h, at.x, at.y - 30, at.x, at.y, 0.35f, Ease::OutBounce);
+
+    (turn == Player::A ? placedA : placedB)++;
+    finishMove(tokens, slot, placedA, placedB, turn, phase, removing);
+}
+
+// Sets the token 'handle' of 'turn' moving to 'target'; it lands in updateTokens()
+inline void moveToken(int handle, int target, TokenStore& tokens, Player turn) {
+    spritesMap["currentPTI"] = spritesMap[turn == Player::A ? "pbmt" : "pamt"];
+    // The move takes as long as it did at constant speed, eased at both ends
+    stopTokenTweens(handle);
+    sf::Vector2f from = tokenSprites.position[handle], to = slotPosition(target) - sf::Vector2f(25, 25);
+    float distance = std::hypot(to.x - from.x, to.y - from.y);
+    tweens.start(TweenMove, handle, from.x, from.y, to.x, to.y, distance / kTokenSpeed, Ease::InOutCubic);
+    tokens.startMove(handle, target);
+    tokens[handle].selected = false;
+}
+
+// Removes the opponent token on 'slot' after a mill, and ends the turn
+inline void removeToken(
+    int slot,
+    TokenStore& tokens,
+    int placedA, int placedB,
+    Player& turn,
+    GamePhase& phase,
+    int& selected,
+    bool& removing)
+{
+    int h = tokens.bySlot[slot];
+    stopTokenTweens(h);
+    tokens.remove(h);
+    selected = -1;
+    removing = false;
+    endTurn(tokens, placedA, placedB, turn, phase);
+}
+
+// Takes back the last step played, if no token is moving: the state is at once what it
+// was before the step, as the delta and the current state give it, and a token whose
+// move is taken back slides home. Works from the win screen too.
+inline void undoStep(
+    TokenStore& tokens,
+    Player& turn,
+    GamePhase& phase,
+    int& selected,
+    int& placedA,
+    int& placedB,
+    bool& removing)
+{
+    bool inGame = phase == GamePhase::Placement || phase == GamePhase::Movement || phase == GamePhase::Win;
+    if (!inGame || undoHistory.done == 0) return;
+    if (selected != -1) {
+        if (tokens[selected].moving) return;
+        tokens[selected].selected = false;
+        selected = -1;
+    }
+    GameDelta d = undoHistory.deltas[--undoHistory.done];
+    tweens.cancel(TweenMill);
+    if (phase == GamePhase::Win) startButtonBounds = sf::FloatRect(340, 620, 240, 80);
+    gameReview.ready = false;
+    removing = false;
+    switch (d.kind()) {
+    case GameDelta::Place: {
+        int h = tokens.placed - 1;
+        turn = tokens[h].owner;
+        stopTokenTweens(h);
+        tokens.removeLast();
+        (turn == Player::A ? placedA : placedB)--;
+        phase = GamePhase::Placement;
+        break;
+    }
+    case GameDelta::Move: {
+        int h = tokens.bySlot[d.to()];
+        turn = tokens[h].owner;
+        tokens.relocate(h, d.slot());
+        stopTokenTweens(h);
+        sf::Vector2f from = tokenSprites.position[h], to = slotPosition(d.slot()) - sf::Vector2f(25, 25);
+        float distance = std::hypot(to.x - from.x, to.y - from.y);
+        tweens.start(TweenUndo, h, from.x, from.y, to.x, to.y, distance / kTokenSpeed, Ease::InOutCubic);
+        phase = GamePhase::Movement;
+        break;
+    }
+    case GameDelta::Remove: { // The turn passed to the player who lost the token
+        Token t;
+        t.owner = turn;
+        t.slotIndex = static_cast<int8_t>(d.slot());
+        tokens.restore(d.handle(), t);
+        sf::Vector2f at = slotPosition(d.slot()) - sf::Vector2f(25, 25);
+        tokenSprites.position[d.handle()] = at - sf::Vector2f(0, 30);
+        tokenSprites.sprite[d.handle()] = static_cast<uint8_t>(turn);
+        tweens.start(TweenDrop, d.handle(), at.x, at.y - 30, at.x, at.y, 0.35f, Ease::OutBounce);
+        turn = opponent(turn);
+        removing = true;
+        phase = d.placing() ? GamePhase::Placement : GamePhase::Movement;
+        break;
+    }
+    }
+    showTurnIndicator(turn, phase);
+    log("Step undone.");
+}
+
+// Plays the next undone step again, as its click did, if no token is moving
+inline void redoStep(
+    TokenStore& tokens,
+    Player& turn,
+    GamePhase& phase,
+    int& selected,
+    int& placedA,
+    int& placedB,
+    bool& removing)
+{
+    bool inPlay = phase == GamePhase::Placement || phase == GamePhase::Movement;
+    if (!inPlay || undoHistory.done == undoHistory.deltas.size()) return;
+    if (selected != -1) {
+        if (tokens[selected].moving) return;
+        tokens[selected].selected = false;
+        selected = -1;
+    }
+    GameDelta d = undoHistory.deltas[undoHistory.done++];
+    switch (d.kind()) {
+    case GameDelta::Place:
+        placeToken(d.slot(), tokens, placedA, placedB, turn, phase, removing);
+        break;
+    case GameDelta::Move:
+        selected = tokens.bySlot[d.slot()];
+        moveToken(selected, d.to(), tokens, turn);
+        break;
+    case GameDelta::Remove:
+        removeToken(d.slot(), tokens, placedA, placedB, turn, phase, selected, removing);
+        break;
+    }
+    log("Step redone.");
+}
+
+// Handles a left click at 'mousePos'; returns false if the click closes the game
+inline bool handleClick(
+    const sf::Vector2f& mousePos,
+    TokenStore& tokens,
+    Player& turn,
+    GamePhase& phase,
+    int& selected,
+    int& placedA,
+    int& placedB,
+    bool& removing)
+{
+    if ((phase == GamePhase::Instructions || phase == GamePhase::About) && startButtonBounds.contains(mousePos)) {
+        phase = GamePhase::Start;
+        startButtonBounds = sf::FloatRect(165, 440, 275, 100);
+        return true;
+    }
+
+    if (phase == GamePhase::Start && startButtonBounds.contains(mousePos)) {
+        phase = GamePhase::Placement;
+        startButtonBounds = sf::FloatRect(340, 620, 240, 80);
+        log("Game started.");
+        beginReview(boardPosition(tokens, placedA, placedB, turn));
+        if (!puzzlePack.puzzles.empty()) {
+            startPuzzle(puzzlePack.next, tokens, placedA, placedB, turn, phase);
+            refreshHighlights(tokens, turn, phase, selected, removing);
+        }
+        return true;
+    }
+
+    if (startButtonBounds.contains(mousePos)) {
+        resetGame(tokens, placedA, placedB, turn, phase, selected, removing);
+        return true;
+    }
+
+    if (phase == GamePhase::Start && instructionsButtonBounds.contains(mousePos)) {
+        phase = GamePhase::Instructions;
+        startButtonBounds = sf::FloatRect(165, 665, 275, 100);
+        return true;
+    }
+
+    if (phase == GamePhase::Start && aboutButtonBounds.contains(mousePos)) {
+        phase = GamePhase::About;
+        startButtonBounds = sf::FloatRect(165, 665, 275, 100);
+        return true;
+    }
+
+    if (phase == GamePhase::Win && exitButtonBounds.contains(mousePos)) {
+        log("Game exited.\n");
+        return false;
+    }
+
+    if ((phase == GamePhase::Placement || phase == GamePhase::Movement) && hintButtonBounds.contains(mousePos)) {
+        requestHint(tokens, turn, phase, placedA, placedB, selected, removing);
+        return true;
+    }
+
+    if (removing && (phase == GamePhase::Placement || phase == GamePhase::Movement)) {
+        // The player closed a mill and must pick an opponent token to remove
+        Player victim = opponent(turn);
+        uint32_t allowed = removableMen(rules, tokens.men[static_cast<int>(victim)]);
+        int slot = slotGrid.pointAt(mousePos.x, mousePos.y, allowed);
+        if (slot != -1) {
+            undoHistory.record(GameDelta::make(GameDelta::Remove, slot, tokens.bySlot[slot], phase == GamePhase::Placement));
+            removeToken(slot, tokens, placedA, placedB, turn, phase, selected, removing);
+        }
+    }
+    else if (phase == GamePhase::Placement) {
+        int slot = getFreeSlotUnderMouse(mousePos, tokens);
+        if (slot != -1) {
+            undoHistory.record(GameDelta::make(GameDelta::Place, slot));
+            placeToken(slot, tokens, placedA, placedB, turn, phase, removing);
+        }
+    }
+    else if (phase == GamePhase::Movement) {
+        // Once the selected token is on its way the turn is over: clicks wait until it lands
+        if (selected != -1 && tokens[selected].moving) return true;
+        int own = slotGrid.pointAt(mousePos.x, mousePos.y, tokens.men[static_cast<int>(turn)]);
+        if (own != -1) {
+            if (selected != -1) tokens[selected].selected = false;
+            selected = tokens.bySlot[own];
+            tokens[selected].selected = true;
+        } else if (selected != -1) {
+            int target = getFreeSlotUnderMouse(mousePos, tokens);
+            Position32 pos = boardPosition(tokens, placedA, placedB, turn);
+            int from = tokens[selected].slotIndex;
+            if (target != -1 && (destinations(rules, pos, from) >> target & 1u)) {
+                undoHistory.record(GameDelta::make(GameDelta::Move, from, target));
+                moveToken(selected, target, tokens, turn);
+            }
+        }
+    }
+    return true;
+}
+
+// Handles one user input event
+// Updates game state based on mouse clicks and the undo (Z) and redo (Y) keys, asks for
+// hints (H), exports the game analysis (E, on the win screen), and updates the hover
+// highlight on pointer moves; returns false if the event closes the game
+inline bool handleEvent(
+    const sf::Event& ev,
+    TokenStore& tokens,
+    Player& turn,
+    GamePhase& phase,
+    int& selected,
+    int& placedA,
+    int& placedB,
+    bool& removing)
+{
+    if (ev.type == sf::Event::Closed) {
+        log("Game closed by user.\n");
+        return false;
+    }
+
+    if (ev.type == sf::Event::MouseMoved) {
+        highlights.pointer = sf::Vector2f(ev.mouseMove.x, ev.mouseMove.y);
+        highlights.hover = slotGrid.pointAt(highlights.pointer.x, highlights.pointer.y, highlights.targets);
+    }
+
+    if (ev.type == sf::Event::MouseButtonPressed && ev.mouseButton.button == sf::Mouse::Left) {
+        highlights.pointer = sf::Vector2f(ev.mouseButton.x, ev.mouseButton.y);
+        bool open = handleClick(highlights.pointer, tokens, turn, phase, selected, placedA, placedB, removing);
+        refreshHighlights(tokens, turn, phase, selected, removing);
+        return open;
+    }
+
+    if (ev.type == sf::Event::KeyPressed && (ev.key.code == sf::Keyboard::Z || ev.key.code == sf::Keyboard::Y)) {
+        if (ev.key.code == sf::Keyboard::Z) undoStep(tokens, turn, phase, selected, placedA, placedB, removing);
+        else redoStep(tokens, turn, phase, selected, placedA, placedB, removing);
+        refreshHighlights(tokens, turn, phase, selected, removing);
+    }
+
+    if (ev.type == sf::Event::KeyPressed && ev.key.code == sf::Keyboard::E && phase == GamePhase::Win)
+        exportReview("game-analysis.txt");
+
+    if (ev.type == sf::Event::KeyPressed && ev.key.code == sf::Keyboard::H) {
+        requestHint(tokens, turn, phase, placedA, placedB, selected, removing);
+        refreshHighlights(tokens, turn, phase, selected, removing);
+    }
+    return true;
+}
+
+// Advances the animations by dt and moves the token sprites along
+// When a moving token's tween ends, the token lands: it takes its new slot and the
+// move is finished (mill, win or turn switch)
+inline void updateTokens(
+    TokenStore& tokens,
+    float dt,
+    Player& turn,
+    int& selected,
+    int placedA,
+    int placedB,
+    bool& removing,
+    GamePhase& phase)
+{
+    tweens.update(dt, [&](uint8_t kind, int key, float x, float y) {
+        if (kind == TweenMill) return;
+        tokenSprites.position[key] = sf::Vector2f(x, y);
+        if (kind == TweenMove) {
+            tokens.land(key);
+            selected = -1;
+            finishMove(tokens, tokens[key].slotIndex, placedA, placedB, turn, phase, removing);
+            refreshHighlights(tokens, turn, phase, selected, removing);
+        }
+    });
+    for (int i = 0; i < tweens.count; ++i)
+        if (tweens.kind[i] != TweenMill) tokenSprites.position[tweens.key[i]] = sf::Vector2f(tweens.x[i], tweens.y[i]);
+}
+
+constexpr float kFrameTime = 1.f / 60; // Frame length while recording and playing back: the frame limit
+
+// Hash of the game state (FNV-1a over the phase, turn, counts and every token, positions
+// included), to check that a playback ends where its recording did
+inline uint64_t stateHash(
+    const TokenStore& tokens,
+    Player turn,
+    GamePhase phase,
+    int placedA,
+    int placedB,
+    bool removing)
+{
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](uint64_t v) {
+        for (int i = 0; i < 8; ++i, v >>= 8) h = (h ^ (v & 0xFF)) * 1099511628211ull;
+    };
+    auto mixFloat = [&mix](float f) {
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof bits);
+        mix(bits);
+    };
+    mix(static_cast<uint64_t>(phase));
+    mix(static_cast<uint64_t>(turn));
+    mix(static_cast<uint64_t>(placedA));
+    mix(static_cast<uint64_t>(placedB));
+    mix(removing);
+    for (uint32_t m = tokens.used; m; m &= m - 1) {
+        const Token& t = tokens[lowestPoint(m)];
+        mix(static_cast<uint64_t>(t.owner));
+        mix(static_cast<uint64_t>(t.slotIndex));
+        mix(static_cast<uint64_t>(t.nextSlotIndex));
+        mix(t.selected | t.moving << 1);
+        mixFloat(tokenSprites.position[lowestPoint(m)].x);
+        mixFloat(tokenSprites.position[lowestPoint(m)].y);
+    }
+    return h;
+}
+
+// An input recording: the board, every event with the frame it arrived in, and the
+// number of frames and stateHash() at the end of the session. The file has a line
+// per event, "<frame> <event type> <fields...>", between a "board <path>" line and an
+// "end <frames> <hash>" line.
+struct Recording {
+    std::string board;
+    std::vector<std::pair<long, sf::Event>> events;
+    long frames = 0;
+    uint64_t hash = 0;
+    bool ended = false; // False if the session never reached its end line
+};
+
+// Appends one event line to a recording
+inline void writeEvent(std::ostream& out, long frame, const sf::Event& ev) {
+    out << frame << ' ' << static_cast<int>(ev.type);
+    if (ev.type == sf::Event::MouseButtonPressed || ev.type == sf::Event::MouseButtonReleased)
+        out << ' ' << static_cast<int>(ev.mouseButton.button) << ' ' << ev.mouseButton.x << ' ' << ev.mouseButton.y;
+    else if (ev.type == sf::Event::MouseMoved)
+        out << ' ' << ev.mouseMove.x << ' ' << ev.mouseMove.y;
+    else if (ev.type == sf::Event::KeyPressed || ev.type == sf::Event::KeyReleased)
+        out << ' ' << static_cast<int>(ev.key.code);
+    out << '\n';
+}
+
+// Reads a recording written with writeEvent()
+inline bool loadRecording(const std::string& path, Recording& rec, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    rec = Recording();
+    std::string line;
+    for (int number = 1; std::getline(in, line); ++number) {
+        std::istringstream fields(line);
+        std::string first;
+        if (!(fields >> first) || first[0] == '#') continue;
+        bool ok = true;
+        if (first == "board") {
+            ok = static_cast<bool>(fields >> rec.board);
+        } else if (first == "end") {
+            ok = static_cast<bool>(fields >> rec.frames >> std::hex >> rec.hash);
+            rec.ended = ok;
+        } else {
+            long frame = std::atol(first.c_str());
+            int type = -1, a = 0, b = 0, c = 0;
+            sf::Event ev;
+            ok = static_cast<bool>(fields >> type) && type >= 0 && type < sf::Event::Count;
+            ev.type = static_cast<sf::Event::EventType>(type);
+            if (ok && (ev.type == sf::Event::MouseButtonPressed || ev.type == sf::Event::MouseButtonReleased)) {
+                ok = static_cast<bool>(fields >> a >> b >> c);
+                ev.mouseButton.button = static_cast<sf::Mouse::Button>(a);
+                ev.mouseButton.x = b;
+                ev.mouseButton.y = c;
+            } else if (ok && ev.type == sf::Event::MouseMoved) {
+                ok = static_cast<bool>(fields >> a >> b);
+                ev.mouseMove.x = a;
+                ev.mouseMove.y = b;
+            } else if (ok && (ev.type == sf::Event::KeyPressed || ev.type == sf::Event::KeyReleased)) {
+                ok = static_cast<bool>(fields >> a);
+                ev.key.code = static_cast<sf::Keyboard::Key>(a);
+            }
+            if (ok && !rec.events.empty() && frame < rec.events.back().first) ok = false;
+            if (ok) rec.events.emplace_back(frame, ev);
+        }
+        if (!ok) {
+            error = path + ":" + std::to_string(number) + ": cannot read \"" + line + "\"";
+            return false;
+        }
+    }
+    if (rec.board.empty()) {
+        error = path + " names no board";
+        return false;
+    }
+    if (!rec.ended) rec.frames = rec.events.empty() ? 0 : rec.events.back().first + 1;
+    return true;
+}
+
+// Reads a puzzle pack; checkPuzzlePack() checks its puzzles once its board is loaded
+inline bool loadPuzzlePack(const std::string& path, PuzzlePack& pack, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    pack = PuzzlePack();
+    std::string line;
+    for (int number = 1; std::getline(in, line); ++number) {
+        std::istringstream fields(line);
+        std::string first, turn, solution;
+        if (!(fields >> first) || first[0] == '#') continue;
+        bool ok = false;
+        if (first == "board") {
+            ok = static_cast<bool>(fields >> pack.board);
+        } else if (first == "puzzle") {
+            Puzzle p;
+            int value = 0;
+            ok = fields >> turn >> std::hex >> p.position.men[0] >> p.position.men[1] >> std::dec >>
+                     p.position.hand[0] >> p.position.hand[1] >> value >> solution &&
+                 (turn == "A" || turn == "B") && value > 0 && value <= kMaxDistance && parseMove(solution, p.solution);
+            p.position.turn = turn == "B" ? Player::B : Player::A;
+            p.value = static_cast<uint8_t>(value);
+            if (ok) pack.puzzles.push_back(p);
+        }
+        if (!ok) {
+            error = path + ":" + std::to_string(number) + ": cannot read \"" + line + "\"";
+            return false;
+        }
+    }
+    if (pack.board.empty()) error = path + " names no board";
+    else if (pack.puzzles.empty()) error = path + " holds no puzzles";
+    return error.empty();
+}
+
+// Checks that every puzzle of a pack is a position of the loaded board that a game can
+// reach, with its solution among the legal moves
+inline bool checkPuzzlePack(const PuzzlePack& pack, std::string& error) {
+    Move moves[kMaxMoves];
+    for (std::size_t i = 0; i < pack.puzzles.size(); ++i) {
+        const Position32& pos = pack.puzzles[i].position;
+        int n = 0;
+        bool ok = !(pos.men[0] & pos.men[1]) && !((pos.men[0] | pos.men[1]) & ~rules.full);
+        for (int p = 0; p < 2 && ok; ++p)
+            ok = pos.hand[p] >= 0 && pos.hand[p] <= rules.men && countMen(pos.men[p]) + pos.hand[p] <= rules.men;
+        if (ok && !isLost(rules, pos) && !isPastGameEnd(rules, pos)) n = generateMoves(rules, pos, moves);
+        if (std::find(moves, moves + n, pack.puzzles[i].solution) == moves + n) {
+            error = "puzzle " + std::to_string(i + 1) + " is not a position a game of " + topology.name + " reaches, with its solution to play";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Self-play input: the next left click of a player who plays random legal moves (the
+// button that starts a game, a free slot, a token to move and then its destination,
+// or an opponent token to remove). Returns false while a token is moving.
+inline bool selfPlayClick(
+    const TokenStore& tokens,
+    Player turn,
+    GamePhase phase,
+    int selected,
+    bool removing,
+    std::mt19937& rng,
+    sf::Event& click)
+{
+    sf::Vector2f at;
+    auto pick = [&rng](uint32_t mask) { // A random set point of a non-empty mask
+        for (int skip = static_cast<int>(rng() % countMen(mask)); skip > 0; --skip) mask &= mask - 1;
+        return lowestPoint(mask);
+    };
+    if (selected != -1 && tokens[selected].moving) return false;
+    uint32_t mine = tokens.men[static_cast<int>(turn)], theirs = tokens.men[1 - static_cast<int>(turn)];
+    uint32_t empty = rules.full & ~(mine | theirs);
+    Position32 pos;
+    pos.men[static_cast<int>(turn)] = mine;
+    pos.men[1 - static_cast<int>(turn)] = theirs;
+    pos.turn = turn;
+
+    if (phase != GamePhase::Placement && phase != GamePhase::Movement) {
+        at = sf::Vector2f(startButtonBounds.left + startButtonBounds.width / 2, startButtonBounds.top + startButtonBounds.height / 2);
+    } else if (removing) {
+        at = slotPosition(pick(removableMen(rules, theirs)));
+    } else if (phase == GamePhase::Placement) {
+        if (!empty) return false;
+        at = slotPosition(pick(empty));
+    } else if (selected != -1 && destinations(rules, pos, tokens[selected].slotIndex)) {
+        at = slotPosition(pick(destinations(rules, pos, tokens[selected].slotIndex)));
+    } else { // Select a token that can move
+        uint32_t movable = 0;
+        for (uint32_t m = mine; m; m &= m - 1)
+            if (destinations(rules, pos, lowestPoint(m))) movable |= m & (~m + 1);
+        if (!movable) return false;
+        at = slotPosition(pick(movable));
+    }
+    click.type = sf::Event::MouseButtonPressed;
+    click.mouseButton.button = sf::Mouse::Left;
+    click.mouseButton.x = static_cast<int>(at.x);
+    click.mouseButton.y = static_cast<int>(at.y);
+    return true;
+}
@@ -9,7 +9,9 @@ GitHub : https://github.com/Sasivarnasarma/ThreeMensMorris
 
 Description :
 A two-player strategy game implemented using SFML. Includes placement and
-movement phases, with win detection logic and a clean UI.
+movement phases, with win detection logic and a clean UI. The board is
+loaded from a description in boards/, so the same engine also plays Six,
+Nine and Twelve Men's Morris.
 
 Dependencies:
 - SFML 2.6
@@ -21,76 +23,11 @@ Notes:
 Version 1.0.0
 */
 
-#include <array>
-#include <cmath>
-#include <ctime>
-#include <vector>
-#include <string>
-#include <iomanip>
-#include <fstream>
-#include <unordered_map>
-#include <SFML/Graphics.hpp>
-
-// Slot structure to represent each position on the grid
-// Each slot has a position and a unique prime number associated with it.
-// We use primes to detect winning combinations by multiplying the primes of selected slots.
-// | --------- |
-// | 0 | 1 | 2 |
-// | --------- |
-// | 3 | 4 | 5 |
-// | --------- |
-// | 6 | 7 | 8 |
-// | --------- |
-
-std::ofstream logFile("game.log");
-
-
-// Slot structure to represent each position on the grid
-struct Slot {
-    sf::Vector2f position; // Position of the slot in the window
-    int prime; // Unique prime number for this slot, used for win detection
-};
-
-// Each slot has a unique prime number used for efficient win detection by multiplying selected slot primes.
-std::array<Slot, 9> slots = {{
-    {{50,  50}, 13}, {{300,  50},  3}, {{550,  50}, 23},
-    {{50, 300}, 17}, {{300, 300}, 11}, {{550, 300},  5},
-    {{50, 550}, 29}, {{300, 550},  7}, {{550, 550}, 19}
-}};
-
-// Winning combinations are defined by indices of slots
-std::array<std::array<int, 3>, 8> winCombos = {{
-    {{0,1,2}}, {{3,4,5}}, {{6,7,8}}, // Horizontal
-    {{0,3,6}}, {{1,4,7}}, {{2,5,8}}, // Vertical
-    {{0,4,8}}, {{2,4,6}} // Diagonal
-}};
-
-enum class Player { A, B }; // Enum to represent players
-enum class GamePhase { Start, About, Instructions, Placement, Movement, Win }; // Enum to represent game phases
-
-// Token structure to represent each player's token
-struct Token {
-    sf::Sprite sprite;       // Visual representation of the token (from SFML)
-    int slotIndex = -1;      // Current slot index where this token is placed (-1 if not placed)
-    int nextSlotIndex = -1;  // The next slot index where the token will move (-1 if no move scheduled)
-    Player owner;            // Which player owns this token (Player::A or Player::B)
-    bool selected = false;   // Is this token currently selected by the player?
-    bool moving = false;     // Is the token currently in motion (moving to targetPos)?
-    sf::Vector2f targetPos;  // The position the token is moving towards
-};
-
-std::unordered_map<std::string, sf::Sprite> spritesMap; // Map to hold sprites by name
-sf::FloatRect startButtonBounds(165, 440, 275, 100); // Bounds for the start button
-sf::FloatRect instructionsButtonBounds(165, 560, 275, 100); // Bounds for the instructions button
-sf::FloatRect aboutButtonBounds(165, 680, 275, 100); // Bounds for the about button
-sf::FloatRect exitButtonBounds(165, 650, 275, 100); // Bounds for the exit button
-
-// Function to log messages to a file with timestamps
-void log(const std::string& message) { 
-    std::time_t now = std::time(nullptr);
-    std::tm* localTime = std::localtime(&now);
-    logFile << "[" << std::put_time(localTime, "%a %b %d %H:%M:%S %Y") << "] - " << message << std::endl;
-}
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include "Game.hpp"
 
 // Function to load assets (textures, images)
 bool loadAssets(
@@ -113,7 +50,7 @@ bool loadAssets(
         !start.loadFromFile("assets/start.png") ||
         !instructions.loadFromFile("assets/instructions.png") ||
         !about.loadFromFile("assets/about.png") ||
-        !board.loadFromFile("assets/board.png") ||
+        (!topology.image.empty() && !board.loadFromFile(topology.image)) ||
         !a.loadFromFile("assets/token_a.png") ||
         !b.loadFromFile("assets/token_b.png") ||
         !active.loadFromFile("assets/active.png") ||
@@ -130,245 +67,54 @@ bool loadAssets(
     return true;
 }
 
-// Returns true if slot 'b' is directly adjacent to slot 'a' on the grid.
-bool isAdjacent(int a, int b) {
-    static const std::array<std::vector<int>, 9> adjacent = {{
-        {1, 3, 4},       // 0 connects to right, down, diagonal (center)
-        {0, 2, 4},       // 1 connects left, right, center
-        {1, 5, 4},       // 2 connects left, down, diagonal
-        {0, 4, 6},       // 3 connects up, right, down
-        {0, 1, 2, 3, 5, 6, 7, 8}, // 4 (center) connects to all adjacent tiles
-        {2, 4, 8},       // 5 connects left, center, down
-        {3, 4, 7},       // 6 connects up, center, right
-        {6, 4, 8},       // 7 connects left, center, right
-        {4, 5, 7}        // 8 connects up, left, center
-    }};
-    for (int n : adjacent[a]) {
-        if (n == b) return true;
-    }
-    return false;
-}
-
-// Computes the product of primes for a given winning combination
-std::vector<int> computeWinProducts(
-    const std::array<std::array<int, 3>, 8>& combos,
-    const std::array<Slot, 9>& slots)
-{
-    std::vector<int> products;
-    for (const auto& combo : combos) {
-        int p = slots[combo[0]].prime * slots[combo[1]].prime * slots[combo[2]].prime;
-        products.push_back(p);
-    }
-    return products;
-}
-
-// Checks if the current tokens of a player form a winning combination
-bool checkWin(
-    const std::vector<Token>& tokens,
-    Player player,
-    const std::vector<int>& winProducts)
-{
-    int product = 1;
-    for (const auto& t : tokens)
-        if (t.owner == player && t.slotIndex != -1)
-            product *= slots[t.slotIndex].prime;
-
-    for (int p : winProducts) {
-        if (product % p == 0)
-            return true;
-    }
-    return false;
-}
-
-// Returns the index of the unoccupied slot under the mouse, or -1 if none.
-int getFreeSlotUnderMouse(const sf::Vector2f& pos, const std::vector<Token>& tokens) {
-    for (int i = 0; i < slots.size(); ++i) {
-        sf::FloatRect area(slots[i].position - sf::Vector2f(25,25), {50,50});
-        bool occupied = false;
-        for (const auto& t : tokens)
-            if (t.slotIndex == i || (t.moving && t.nextSlotIndex == i))
-                occupied = true;
-        if (!occupied && area.contains(pos))
-            return i;
+// Builds the board lines for descriptions that come without artwork
+sf::VertexArray buildBoardLines() {
+    const float half = 3.f; // Half of the line width
+    sf::VertexArray lines(sf::Quads);
+    for (const auto& e : topology.edges) {
+        sf::Vector2f a = slotPosition(e[0]), b = slotPosition(e[1]);
+        sf::Vector2f dir = b - a;
+        float len = std::sqrt(dir.x * dir.x + dir.y * dir.y);
+        sf::Vector2f normal(-dir.y / len * half, dir.x / len * half);
+        lines.append(sf::Vertex(a + normal, sf::Color::Black));
+        lines.append(sf::Vertex(b + normal, sf::Color::Black));
+        lines.append(sf::Vertex(b - normal, sf::Color::Black));
+        lines.append(sf::Vertex(a - normal, sf::Color::Black));
     }
-    return -1;
-}
-
-// Resets the game state
-void resetGame(
-    std::vector<Token>& tokens,
-    int& placedA, int& placedB,
-    Player& turn,
-    GamePhase& phase,
-    Token*& selected)
-{
-    if (phase == GamePhase::Win) {
-        phase = GamePhase::Start;
-        startButtonBounds = sf::FloatRect(165, 440, 275, 100);
-    } else {
-        phase = GamePhase::Placement;
-        startButtonBounds = sf::FloatRect(340, 620, 240, 80);
-        log("Game reset.");
-    }
-    tokens.clear();
-    placedA = placedB = 0;
-    turn = Player::A;
-    selected = nullptr;
-    spritesMap["currentPTI"] = spritesMap["papt"];
+    return lines;
 }
 
 // Handles user input events
-// Updates game state based on mouse clicks and key presses
+// Polls the window and applies each event to the game state (see Game.hpp),
+// writing it to 'record' with the frame number when a session is being recorded
 void handleEvents(
     sf::RenderWindow& window,
-    std::vector<Token>& tokens,
+    TokenStore& tokens,
     Player& turn,
     GamePhase& phase,
-    Token*& selected,
+    int& selected,
     int& placedA,
     int& placedB,
-    const sf::Texture& tokenATex,
-    const sf::Texture& tokenBTex,
-    const std::vector<int>& winProducts)
+    bool& removing,
+    std::ostream* record,
+    long frame)
 {
     sf::Event ev;
     while (window.pollEvent(ev)) {
-        if (ev.type == sf::Event::Closed) {
-            log("Game closed by user.\n");
-            window.close();
+        // Mouse positions are handled, and recorded, in board coordinates, whatever the window size
+        if (ev.type == sf::Event::MouseButtonPressed || ev.type == sf::Event::MouseButtonReleased) {
+            sf::Vector2f p = window.mapPixelToCoords({ev.mouseButton.x, ev.mouseButton.y});
+            ev.mouseButton.x = static_cast<int>(p.x);
+            ev.mouseButton.y = static_cast<int>(p.y);
+        } else if (ev.type == sf::Event::MouseMoved) {
+            sf::Vector2f p = window.mapPixelToCoords({ev.mouseMove.x, ev.mouseMove.y});
+            ev.mouseMove.x = static_cast<int>(p.x);
+            ev.mouseMove.y = static_cast<int>(p.y);
         }
-
-        if (ev.type == sf::Event::MouseButtonPressed && ev.mouseButton.button == sf::Mouse::Left) {
-
-            sf::Vector2f mousePos(ev.mouseButton.x, ev.mouseButton.y);
-
-            if ((phase == GamePhase::Instructions || phase == GamePhase::About) && startButtonBounds.contains(mousePos)) {
-                phase = GamePhase::Start;
-                startButtonBounds = sf::FloatRect(165, 440, 275, 100);
-                return;
-            }
-
-            if (phase == GamePhase::Start && startButtonBounds.contains(mousePos)) {
-                phase = GamePhase::Placement;
-                startButtonBounds = sf::FloatRect(340, 620, 240, 80);
-                log("Game started.");
-                return;
-            }
-
-            if (startButtonBounds.contains(mousePos)) {
-                resetGame(tokens, placedA, placedB, turn, phase, selected);
-                return;
-            }
-
-            if (phase == GamePhase::Start && instructionsButtonBounds.contains(mousePos)) {
-                phase = GamePhase::Instructions;
-                startButtonBounds = sf::FloatRect(165, 665, 275, 100);
-                return;
-            }
-
-            if (phase == GamePhase::Start && aboutButtonBounds.contains(mousePos)) {
-                phase = GamePhase::About;
-                startButtonBounds = sf::FloatRect(165, 665, 275, 100);
-                return;
-            }
-
-            if (phase == GamePhase::Win && exitButtonBounds.contains(mousePos)) {
-                window.close();
-                log("Game exited.\n");
-                return;
-            }
-
-            if (phase == GamePhase::Placement) {
-                int slot = getFreeSlotUnderMouse(mousePos, tokens);
-                if (slot != -1) {
-                    Token t;
-                    t.owner = turn;
-                    t.slotIndex = slot;
-                    t.sprite.setTexture(turn == Player::A ? tokenATex : tokenBTex);
-                    t.sprite.setPosition(slots[slot].position - sf::Vector2f(25, 25));
-                    tokens.push_back(t);
-
-                    spritesMap["currentPTI"] = spritesMap[turn == Player::A ? "pbpt" : "papt"];
-
-                    if (checkWin(tokens, turn, winProducts)) {
-                        log((turn == Player::A ? "Player A" : "Player B") + std::string(" wins!"));
-                        spritesMap["winner"] = spritesMap[turn == Player::A ? "winA" : "winB"];
-                        phase = GamePhase::Win;
-                        startButtonBounds = sf::FloatRect(165, 510, 275, 100);
-                        return;
-                    }
-
-                    (turn == Player::A ? placedA : placedB)++;
-                    if (placedA == 3 && placedB == 3){
-                        phase = GamePhase::Movement;
-                        spritesMap["currentPTI"] = spritesMap["pamt"];
-                    }
-
-                    turn = (turn == Player::A ? Player::B : Player::A);
-                }
-            }
-            else if (phase == GamePhase::Movement) {
-                bool clicked = false;
-                for (auto& t : tokens) {
-                    if (t.owner == turn && t.sprite.getGlobalBounds().contains(mousePos)) {
-                        if (selected) selected->selected = false;
-                        t.selected = true;
-                        selected = &t;
-                        clicked = true;
-                        break;
-                    }
-                }
-
-                if (!clicked && selected && !selected->moving) {
-                    int target = getFreeSlotUnderMouse(mousePos, tokens);
-                    if (target != -1 && isAdjacent(selected->slotIndex, target)) {
-                        spritesMap["currentPTI"] = spritesMap[turn == Player::A ? "pbmt" : "pamt"];
-                        selected->moving = true;
-                        selected->targetPos = slots[target].position - sf::Vector2f(25, 25);
-                        selected->nextSlotIndex = target;
-                        selected->selected = false;
-                    }
-                }
-            }
-        }
-    }
-}
-
-// Updates the positions of tokens that are currently moving
-// If a token reaches its target position, it updates its slot index and checks for a win
-void updateTokens(
-    std::vector<Token>& tokens,
-    float dt,
-    float speed,
-    Player& turn,
-    Token*& selected,
-    sf::RenderWindow& window,
-    const std::vector<int>& winProducts,
-    GamePhase& phase)
-{
-    for (auto& t : tokens) {
-        if (t.moving) {
-            sf::Vector2f dir = t.targetPos - t.sprite.getPosition();
-            float dist = std::sqrt(dir.x * dir.x + dir.y * dir.y);
-            if (dist < speed * dt) {
-                t.sprite.setPosition(t.targetPos);
-                t.slotIndex = t.nextSlotIndex;
-                t.moving = false;
-                t.nextSlotIndex = -1;
-
-                if (checkWin(tokens, t.owner, winProducts)) {
-                    log((turn == Player::A ? "Player A" : "Player B") + std::string(" wins!"));
-                    spritesMap["winner"] = spritesMap[turn == Player::A ? "winA" : "winB"];
-                    phase = GamePhase::Win;
-                    startButtonBounds = sf::FloatRect(165, 510, 275, 100);
-                }
-
-                selected = nullptr;
-                turn = (turn == Player::A ? Player::B : Player::A);
-            } else {
-                sf::Vector2f step = dir / dist * speed * dt;
-                t.sprite.move(step);
-            }
+        if (record) writeEvent(*record, frame, ev);
+        if (!handleEvent(ev, tokens, turn, phase, selected, placedA, placedB, removing)) {
+            window.close();
+            return;
         }
     }
 }
@@ -376,10 +122,18 @@ void updateTokens(
 // Draws the current game state to the window
 void drawGame(
     sf::RenderWindow& window,
-    const std::vector<Token>& tokens,
+    const TokenStore& tokens,
+    const sf::VertexArray& boardLines,
+    const sf::Texture& tokenATex,
+    const sf::Texture& tokenBTex,
     const sf::Texture& activeTex,
-    const GamePhase& phase)
+    const GamePhase& phase,
+    bool removing)
 {
+    int flash = -1; // Tween of a closed mill that is flashing
+    for (int i = 0; i < tweens.count; ++i)
+        if (tweens.kind[i] == TweenMill) flash = i;
+
     window.clear(sf::Color::White);
     if (phase == GamePhase::Start) {
         spritesMap["start"].setPosition(0, 0);
@@ -393,43 +147,221 @@ void drawGame(
         spritesMap["about"].setPosition(0, 0);
         window.draw(spritesMap["about"]);
 
-    } else if (phase == GamePhase::Win) {
+    } else if (phase == GamePhase::Win && flash == -1) {
         spritesMap["winner"].setPosition(0, 0);
         window.draw(spritesMap["winner"]);
 
-    } else if (phase == GamePhase::Placement || phase == GamePhase::Movement) {
+        // The game analysis along the bottom: a mark per move, Player A's moves above
+        // Player B's, grey if the move kept the result, amber if it gave up a win, red if
+        // it lost the game. Outlines only while it is still being worked out.
+        std::size_t first = gameReview.start.turn == Player::B; // A puzzle may start with Player B
+        std::size_t moves = gameReview.ready ? gameReview.review.size() : playedMoves().size();
+        float step = std::min(16.f, 560.f / std::max<std::size_t>(1, (moves + first + 1) / 2));
+        sf::RectangleShape mark(sf::Vector2f(step - 3, 10));
+        for (std::size_t i = 0; i < moves; ++i) {
+            sf::Color color(150, 150, 150);
+            bool b = (i + first) & 1;
+            if (gameReview.ready && gameReview.review[i].changedResult())
+                color = resultClass(gameReview.review[i].after) < 0 ? sf::Color(210, 40, 40) : sf::Color(240, 160, 20);
+            mark.setFillColor(gameReview.ready ? color : sf::Color::Transparent);
+            mark.setOutlineColor(color);
+            mark.setOutlineThickness(gameReview.ready ? 0.f : 1.f);
+            mark.setPosition(20 + step * ((i + first) / 2), b ? 784.f : 770.f);
+            window.draw(mark);
+        }
+
+    } else { // Placement or movement, or a win while its mill flashes
 
-        spritesMap["board"].setPosition(0, 0);
-        window.draw(spritesMap["board"]);
+        if (topology.image.empty()) {
+            window.draw(boardLines);
+            sf::CircleShape point(10.f);
+            point.setFillColor(sf::Color::Black);
+            for (int i = 0; i < rules.points; ++i) {
+                point.setPosition(slotPosition(i) - sf::Vector2f(10, 10));
+                window.draw(point);
+            }
+        } else {
+            spritesMap["board"].setPosition(0, 0);
+            window.draw(spritesMap["board"]);
+        }
         spritesMap["currentPTI"].setPosition(0, 600);
         window.draw(spritesMap["currentPTI"]);
 
-        for (const auto& t : tokens) {
-            window.draw(t.sprite);
-            if (t.selected) {
-                sf::Sprite overlay(activeTex);
-                overlay.setPosition(t.sprite.getPosition());
+        // Legal destinations of the selected token are marked with a dot
+        sf::CircleShape dot(12.f);
+        dot.setFillColor(sf::Color(40, 170, 60, 170));
+        for (uint32_t m = highlights.destinations; m; m &= m - 1) {
+            dot.setPosition(slotPosition(lowestPoint(m)) - sf::Vector2f(12, 12));
+            window.draw(dot);
+        }
+
+        // While removing, the opponent tokens that may be taken are highlighted
+        uint32_t removable = removing ? highlights.targets : 0;
+        sf::Sprite sprites[2] = {sf::Sprite(tokenATex), sf::Sprite(tokenBTex)}; // By sprite ID
+        sf::Sprite overlay(activeTex);
+        for (uint32_t m = tokens.used; m; m &= m - 1) {
+            int h = lowestPoint(m);
+            const Token& t = tokens[h];
+            sf::Sprite& sprite = sprites[tokenSprites.sprite[h]];
+            sprite.setPosition(tokenSprites.position[h]);
+            window.draw(sprite);
+            if (t.selected || (t.slotIndex != -1 && (removable >> t.slotIndex & 1u))) {
+                overlay.setPosition(tokenSprites.position[h]);
                 window.draw(overlay);
             }
         }
+
+        // The slot under the pointer is ringed when a click there does something
+        if (highlights.hover != -1) {
+            sf::CircleShape ring(kTokenSize / 2 + 2);
+            ring.setFillColor(sf::Color::Transparent);
+            ring.setOutlineThickness(3.f);
+            ring.setOutlineColor(sf::Color(40, 120, 220));
+            ring.setPosition(slotPosition(highlights.hover) - sf::Vector2f(kTokenSize / 2 + 2, kTokenSize / 2 + 2));
+            window.draw(ring);
+        }
+
+        // The hinted move: its token and slot ringed in amber and joined by a line, and
+        // the token it takes ringed in red
+        sf::CircleShape ring(kTokenSize / 2 + 6);
+        ring.setFillColor(sf::Color::Transparent);
+        ring.setOutlineThickness(4.f);
+        const Move& h = highlights.hint;
+        if (h.to >= 0) {
+            ring.setOutlineColor(sf::Color(240, 160, 20));
+            for (int slot : {static_cast<int>(h.from), static_cast<int>(h.to)}) {
+                if (slot < 0) continue;
+                ring.setPosition(slotPosition(slot) - sf::Vector2f(kTokenSize / 2 + 6, kTokenSize / 2 + 6));
+                window.draw(ring);
+            }
+            if (h.from >= 0) {
+                sf::Vector2f a = slotPosition(h.from), b = slotPosition(h.to), dir = b - a;
+                float len = std::sqrt(dir.x * dir.x + dir.y * dir.y);
+                sf::Vector2f normal(-dir.y / len * 2, dir.x / len * 2);
+                sf::VertexArray line(sf::Quads);
+                sf::Color amber(240, 160, 20, 200);
+                line.append(sf::Vertex(a + normal, amber));
+                line.append(sf::Vertex(b + normal, amber));
+                line.append(sf::Vertex(b - normal, amber));
+                line.append(sf::Vertex(a - normal, amber));
+                window.draw(line);
+            }
+        }
+        if (h.remove >= 0) {
+            ring.setOutlineColor(sf::Color(210, 40, 40));
+            ring.setPosition(slotPosition(h.remove) - sf::Vector2f(kTokenSize / 2 + 6, kTokenSize / 2 + 6));
+            window.draw(ring);
+        }
+
+        // The hint button, a bulb that shows an outline while its search runs
+        if (phase == GamePhase::Placement || phase == GamePhase::Movement) {
+            sf::CircleShape bulb(hintButtonBounds.width / 2);
+            bulb.setFillColor(sf::Color(250, 200, 60));
+            bulb.setOutlineColor(sf::Color(240, 160, 20));
+            bulb.setOutlineThickness(hint.searching ? 3.f : 0.f);
+            bulb.setPosition(hintButtonBounds.left, hintButtonBounds.top);
+            window.draw(bulb);
+            sf::RectangleShape base(sf::Vector2f(10, 6));
+            base.setFillColor(sf::Color(90, 60, 40));
+            base.setPosition(hintButtonBounds.left + hintButtonBounds.width / 2 - 5, hintButtonBounds.top + hintButtonBounds.height - 4);
+            window.draw(base);
+        }
+
+        // A closed mill pulses three times
+        if (flash != -1) {
+            float pulse = std::abs(std::sin(tweens.x[flash] * 3 * 3.14159265f));
+            sf::CircleShape glow(kTokenSize / 2 + 4);
+            glow.setFillColor(sf::Color::Transparent);
+            glow.setOutlineThickness(5.f);
+            glow.setOutlineColor(sf::Color(240, 190, 30, static_cast<uint8_t>(255 * pulse)));
+            for (uint32_t m = static_cast<uint32_t>(tweens.key[flash]); m; m &= m - 1) {
+                glow.setPosition(slotPosition(lowestPoint(m)) - sf::Vector2f(kTokenSize / 2 + 4, kTokenSize / 2 + 4));
+                window.draw(glow);
+            }
+        }
     }
     window.display();
 }
 
 
 // Main function to initialize the game, load assets, and run the game loop
-int main() {
+// Arguments: [board.txt] (default boards/three.txt), and optionally
+//   --record <file>             records the input of the session, frame by frame
+//   --play <file> [--headless]  plays a recording back as fast as possible (without a
+//                               window when headless) and checks that it ends the same way
+//   --self-play <games> [--seed S] [--headless]
+//                               plays games of random legal moves as fast as possible
+//   --puzzles <pack.txt>        plays the puzzles of a pack (tools/Puzzles.cpp) on its board
+//                               (not while recording, playing back or self-playing)
+int main(int argc, char* argv[]) {
+    std::string boardPath = "boards/three.txt", recordPath, playPath, puzzlePath;
+    bool headless = false;
+    long selfPlayGames = 0;
+    unsigned seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--record" && i + 1 < argc) recordPath = argv[++i];
+        else if (arg == "--play" && i + 1 < argc) playPath = argv[++i];
+        else if (arg == "--puzzles" && i + 1 < argc) puzzlePath = argv[++i];
+        else if (arg == "--self-play" && i + 1 < argc) selfPlayGames = std::atol(argv[++i]);
+        else if (arg == "--seed" && i + 1 < argc) seed = static_cast<unsigned>(std::atol(argv[++i]));
+        else if (arg == "--headless") headless = true;
+        else boardPath = arg;
+    }
+    const bool playing = !playPath.empty();
+    const bool selfPlay = !playing && selfPlayGames > 0;
+    headless = headless && (playing || selfPlay);
+
+    Recording recording;
+    if (playing) {
+        std::string error;
+        if (!loadRecording(playPath, recording, error)) {
+            log("Failed to load recording: " + error);
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        boardPath = recording.board;
+    }
+
+    if (!puzzlePath.empty() && !playing && !selfPlay && recordPath.empty()) {
+        std::string error;
+        if (!loadPuzzlePack(puzzlePath, puzzlePack, error)) {
+            log("Failed to load puzzles: " + error);
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        boardPath = puzzlePack.board;
+    }
+
+    analyzeGames = !playing && !selfPlay;
     log("Game started.");
-    sf::RenderWindow window(sf::VideoMode(600, 800), "Three Men's Morris", sf::Style::Titlebar | sf::Style::Close);
-    window.setFramerateLimit(60);
+    if (!loadBoard(boardPath)) {
+        return 1;
+    }
+    if (!puzzlePack.puzzles.empty()) {
+        std::string error;
+        if (!checkPuzzlePack(puzzlePack, error)) {
+            log("Failed to load puzzles: " + error);
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        log("Loaded " + std::to_string(puzzlePack.puzzles.size()) + " puzzles from " + puzzlePath + ".");
+    }
 
+    std::unique_ptr<sf::RenderWindow> window;
     sf::Image icon;
     sf::Texture startTex, instructionsTex, aboutTex, boardTex, tokenATex, tokenBTex, activeTex, paptTex, pbptTex, pamtTex, pbmtTex, winATex, winBTex;
-    if (!loadAssets(icon, startTex, instructionsTex, aboutTex, boardTex, tokenATex, tokenBTex, activeTex, paptTex, pbptTex, pamtTex, pbmtTex, winATex, winBTex)) {
-        return 1;
+    if (!headless) {
+        window = std::make_unique<sf::RenderWindow>(sf::VideoMode(600, 800), topology.name, sf::Style::Titlebar | sf::Style::Close);
+        if (playing || selfPlay) window->setVerticalSyncEnabled(false); // Unthrottled: these are benchmarks
+        else window->setFramerateLimit(60);
+
+        if (!loadAssets(icon, startTex, instructionsTex, aboutTex, boardTex, tokenATex, tokenBTex, activeTex, paptTex, pbptTex, pamtTex, pbmtTex, winATex, winBTex)) {
+            return 1;
+        }
+
+        window->setIcon(icon.getSize().x, icon.getSize().y, icon.getPixelsPtr());
     }
-    
-    window.setIcon(icon.getSize().x, icon.getSize().y, icon.getPixelsPtr());
 
     spritesMap["start"] = sf::Sprite(startTex);
     spritesMap["instructions"] = sf::Sprite(instructionsTex);
@@ -444,23 +376,93 @@ int main() {
     spritesMap["winB"] = sf::Sprite(winBTex);
     spritesMap["winner"] = sf::Sprite();
 
-    std::vector<Token> tokens;
-    Token* selected = nullptr;
+    TokenStore tokens;
+    int selected = -1; // Handle of the selected token
     Player turn = Player::A;
     GamePhase phase = GamePhase::Start;
     int placedA = 0, placedB = 0;
+    bool removing = false; // True while the player who closed a mill picks a token to remove
 
-    std::vector<int> winProducts = computeWinProducts(winCombos, slots);
+    sf::VertexArray boardLines = buildBoardLines();
 
-    const float speed = 400.f;
-    sf::Clock clock;
+    // Recorded sessions run on a fixed frame time, so that playing them back repeats them exactly
+    std::ofstream record;
+    if (!recordPath.empty()) {
+        record.open(recordPath);
+        record << "# " << topology.name << " input recording: <frame> <event type> <fields...>\n";
+        record << "board " << boardPath << "\n";
+    }
 
-    while (window.isOpen()) {
+    sf::Clock clock;
+    auto begin = std::chrono::steady_clock::now();
+    long frame = 0;
+    std::size_t next = 0; // Next recorded event to play
+    std::mt19937 rng(seed);
+    long games = 0, gameStart = 0;
+    const long maxGameFrames = 6000; // Self-play games still going after this many frames are reset
+
+    for (bool open = true; open; ++frame) {
         float dt = clock.restart().asSeconds();
-        handleEvents(window, tokens, turn, phase, selected, placedA, placedB, tokenATex, tokenBTex, winProducts);
-        updateTokens(tokens, dt, speed, turn, selected, window, winProducts, phase);
-        drawGame(window, tokens, activeTex, phase);
+        if (playing) {
+            dt = kFrameTime;
+            for (; open && next < recording.events.size() && recording.events[next].first == frame; ++next)
+                open = handleEvent(recording.events[next].second, tokens, turn, phase, selected, placedA, placedB, removing);
+            sf::Event ev;
+            while (window && window->pollEvent(ev))
+                if (ev.type == sf::Event::Closed) open = false;
+            if (frame + 1 >= recording.frames) open = false;
+        } else if (selfPlay) {
+            dt = kFrameTime;
+            sf::Event click;
+            bool inPlay = phase == GamePhase::Placement || phase == GamePhase::Movement;
+            if (inPlay && frame - gameStart > maxGameFrames) {
+                resetGame(tokens, placedA, placedB, turn, phase, selected, removing);
+                ++games;
+                gameStart = frame;
+            } else if (selfPlayClick(tokens, turn, phase, selected, removing, rng, click)) {
+                handleEvent(click, tokens, turn, phase, selected, placedA, placedB, removing);
+                if (inPlay && phase == GamePhase::Win) ++games;
+                if (!inPlay && phase == GamePhase::Placement) gameStart = frame;
+            }
+            sf::Event ev;
+            while (window && window->pollEvent(ev))
+                if (ev.type == sf::Event::Closed) open = false;
+            if (games >= selfPlayGames) open = false;
+        } else {
+            if (record.is_open()) dt = kFrameTime;
+            handleEvents(*window, tokens, turn, phase, selected, placedA, placedB, removing,
+                         record.is_open() ? &record : nullptr, frame);
+            open = window->isOpen();
+        }
+        bool inPlay = phase == GamePhase::Placement || phase == GamePhase::Movement;
+        updateTokens(tokens, dt, turn, selected, placedA, placedB, removing, phase);
+        pollHint(tokens, turn, phase, selected, removing);
+        updateReview(phase);
+        if (selfPlay && inPlay && phase == GamePhase::Win) ++games;
+        if (window) drawGame(*window, tokens, boardLines, tokenATex, tokenBTex, activeTex, phase, removing);
+    }
+
+    uint64_t hash = stateHash(tokens, turn, phase, placedA, placedB, removing);
+    if (record.is_open()) {
+        record << "end " << frame << " " << std::hex << hash << "\n";
+        log("Recorded " + std::to_string(frame) + " frames to " + recordPath + ".");
+    }
+    int status = 0;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    char summary[256] = "";
+    if (playing) {
+        std::snprintf(summary, sizeof summary, "Played %ld frames%s in %.3fs (%.0f frames/s), final state %016llx%s", frame,
+                      headless ? " headless" : "", seconds, frame / seconds, static_cast<unsigned long long>(hash),
+                      !recording.ended ? ", the recording has no end state" : hash == recording.hash ? ", as recorded" : ", DIFFERS from the recording");
+        status = recording.ended && hash != recording.hash ? 1 : 0;
+    } else if (selfPlay) {
+        std::snprintf(summary, sizeof summary, "Self-played %ld games, %ld frames%s in %.3fs (%.0f frames/s), final state %016llx",
+                      games, frame, headless ? " headless" : "", seconds, frame / seconds, static_cast<unsigned long long>(hash));
+    }
+    if (*summary) {
+        log(summary);
+        std::printf("%s\n", summary);
     }
     logFile.close();
-    return 0;
-}
\ No newline at end of file
+    return status;
+}
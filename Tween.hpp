@@ -0,0 +1,133 @@
+/*
+Tweens - a fixed pool of animations stepped together, used by Game.hpp
+
+A tween takes a 2D value from one point to another over a duration, along an
+easing curve. The pool keeps every field in its own array (structure of
+arrays), so a frame is one pass over plain floats, and starting or finishing a
+tween never allocates. Each tween carries a kind and a key that mean something
+to its owner (what it animates); finished tweens are handed back with them to
+the callback given to update(), and the last tween takes their place.
+*/
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+enum class Ease : uint8_t { Linear, InOutCubic, OutBack, OutBounce };
+
+// Eased progress for a linear progress t in [0, 1]
+inline float ease(Ease curve, float t) {
+    switch (curve) {
+    case Ease::Linear:
+        return t;
+    case Ease::InOutCubic:
+        return t < 0.5f ? 4 * t * t * t : 1 - 4 * (1 - t) * (1 - t) * (1 - t);
+    case Ease::OutBack: { // Overshoots by about 10% before settling
+        const float c = 1.70158f, u = t - 1;
+        return 1 + (c + 1) * u * u * u + c * u * u;
+    }
+    case Ease::OutBounce: {
+        const float n = 7.5625f, d = 2.75f;
+        if (t < 1 / d) return n * t * t;
+        if (t < 2 / d) { t -= 1.5f / d; return n * t * t + 0.75f; }
+        if (t < 2.5f / d) { t -= 2.25f / d; return n * t * t + 0.9375f; }
+        t -= 2.625f / d;
+        return n * t * t + 0.984375f;
+    }
+    }
+    return t;
+}
+
+template <int Capacity>
+struct TweenPool {
+    static constexpr int kCapacity = Capacity;
+
+    int count = 0;
+    std::array<float, Capacity> fromX{}, fromY{}, toX{}, toY{};
+    std::array<float, Capacity> elapsed{}, duration{};
+    std::array<float, Capacity> x{}, y{}; // Current values
+    std::array<Ease, Capacity> curve{};
+    std::array<uint8_t, Capacity> kind{};
+    std::array<int, Capacity> key{};
+
+    void clear() { count = 0; }
+
+    // Starts a tween from (x0, y0) to (x1, y1); returns false if the pool is full
+    bool start(uint8_t k, int id, float x0, float y0, float x1, float y1, float seconds, Ease e) {
+        if (count == Capacity) return false;
+        int i = count++;
+        kind[i] = k;
+        key[i] = id;
+        fromX[i] = x[i] = x0;
+        fromY[i] = y[i] = y0;
+        toX[i] = x1;
+        toY[i] = y1;
+        elapsed[i] = 0;
+        duration[i] = seconds;
+        curve[i] = e;
+        return true;
+    }
+
+    // Index of the running tween of this kind and key, or -1
+    int find(uint8_t k, int id) const {
+        for (int i = 0; i < count; ++i)
+            if (kind[i] == k && key[i] == id) return i;
+        return -1;
+    }
+
+    // Stops the tween of this kind and key, if running, without reporting it
+    void cancel(uint8_t k, int id) {
+        int i = find(k, id);
+        if (i != -1) remove(i);
+    }
+
+    // Stops every tween of this kind
+    void cancel(uint8_t k) {
+        for (int i = 0; i < count;) {
+            if (kind[i] == k) remove(i);
+            else ++i;
+        }
+    }
+
+    // Advances every tween by dt seconds, then calls done(kind, key, x, y) for each one
+    // that finished, with its end values. done() may start new tweens.
+    template <typename Done>
+    void update(float dt, Done&& done) {
+        for (int i = 0; i < count; ++i) {
+            elapsed[i] += dt;
+            float t = elapsed[i] < duration[i] ? elapsed[i] / duration[i] : 1.f;
+            float e = ease(curve[i], t);
+            x[i] = fromX[i] + (toX[i] - fromX[i]) * e;
+            y[i] = fromY[i] + (toY[i] - fromY[i]) * e;
+        }
+        for (int i = 0; i < count;) {
+            if (elapsed[i] < duration[i]) {
+                ++i;
+                continue;
+            }
+            uint8_t k = kind[i];
+            int id = key[i];
+            float endX = toX[i], endY = toY[i];
+            remove(i);
+            done(k, id, endX, endY);
+        }
+    }
+
+private:
+    void remove(int i) {
+        int last = --count;
+        fromX[i] = fromX[last];
+        fromY[i] = fromY[last];
+        toX[i] = toX[last];
+        toY[i] = toY[last];
+        elapsed[i] = elapsed[last];
+        duration[i] = duration[last];
+        x[i] = x[last];
+        y[i] = y[last];
+        curve[i] = curve[last];
+        kind[i] = kind[last];
+        key[i] = key[last];
+    }
+};
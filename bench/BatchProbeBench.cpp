@@ -0,0 +1,133 @@
+/*
+Batch probe benchmark - probeBatch() against one probeTablebase() per position
+
+Build: g++ -std=c++17 -O2 -pthread bench/BatchProbeBench.cpp -o BatchProbeBench
+Usage: BatchProbeBench <board.txt> <tablebase.tb> [--positions N] [--threads T] [--cache N]
+       (default 1 million positions, all hardware threads, 256 cached blocks)
+
+Two workloads of N positions each, both under random board symmetries and with
+either player to move:
+  random    positions drawn uniformly from the whole tablebase;
+  children  every child of random positions, in move order, as an analysis
+            of game trees asks for them (clustered in few partitions).
+Each is probed one position at a time through a BlockCache of N blocks, then
+with probeBatch() on one thread and on T threads. Prints ns per position and
+positions per second, and checks that all three give the same values.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include "../engine/BatchProbe.hpp"
+
+template <typename F>
+double seconds(F&& body) {
+    auto begin = std::chrono::steady_clock::now();
+    body();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::fprintf(stderr, "Usage: %s <board.txt> <tablebase.tb> [--positions N] [--threads T] [--cache N]\n", argv[0]);
+        return 2;
+    }
+    std::size_t count = 1000000, cacheBlocks = 256;
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    for (int i = 3; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--positions") && i + 1 < argc) count = static_cast<std::size_t>(std::atoll(argv[++i]));
+        else if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) threads = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--cache") && i + 1 < argc) cacheBlocks = static_cast<std::size_t>(std::atoi(argv[++i]));
+        else {
+            std::fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    threads = std::max(1, threads);
+    count = std::max<std::size_t>(1, count);
+
+    Topology topology;
+    Rules32 rules;
+    std::string error;
+    if (!loadTopology(argv[1], topology, error) || !compileTopology(topology, rules, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    TablebaseFile tb;
+    if (!tb.open(argv[2], error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    PositionIndexer<uint32_t> indexer(rules);
+    if (tb.points() != rules.points || tb.men() != rules.men || tb.symmetries() != indexer.symmetries()) {
+        std::fprintf(stderr, "%s was not built for %s\n", argv[2], topology.name.c_str());
+        return 1;
+    }
+
+    // A random stored position, under a random symmetry, with either player to move
+    std::mt19937_64 rng(1);
+    uint64_t total = 0;
+    for (const auto& p : tb.partitions()) total += p.positions;
+    auto randomPosition = [&] {
+        uint64_t r = rng() % total;
+        const TablebasePartition* part = &tb.partitions()[0];
+        for (const auto& p : tb.partitions()) {
+            if (r < p.positions) {
+                part = &p;
+                break;
+            }
+            r -= p.positions;
+        }
+        Position32 canonical = partitionPosition(indexer, part->key, r), pos = canonical;
+        int s = static_cast<int>(rng() % indexer.symmetries());
+        for (int p = 0; p < 2; ++p) pos.men[p] = indexer.transform(s, canonical.men[p]);
+        if (rng() & 1) {
+            std::swap(pos.men[0], pos.men[1]);
+            std::swap(pos.hand[0], pos.hand[1]);
+            pos.turn = Player::B;
+        }
+        return pos;
+    };
+    std::vector<Position32> random(count), children;
+    for (auto& p : random) p = randomPosition();
+    Move moves[kMaxMoves];
+    while (children.size() < count) {
+        Position32 pos = randomPosition();
+        int n = isLost(rules, pos) ? 0 : generateMoves(rules, pos, moves);
+        for (int m = 0; m < n && children.size() < count; ++m) children.push_back(applyMove(pos, moves[m]));
+    }
+
+    std::printf("%s: %llu positions in %llu blocks of %u, %zu positions per workload, %d threads\n", tb.name().c_str(),
+                static_cast<unsigned long long>(total), static_cast<unsigned long long>(tb.blockCount()), tb.blockSize(),
+                count, threads);
+    std::printf("  %-9s %-28s %10s %12s\n", "workload", "probe", "ns/pos", "positions/s");
+    int status = 0;
+    for (auto* workload : {&random, &children}) {
+        const char* name = workload == &random ? "random" : "children";
+        const Position32* in = workload->data();
+        std::vector<uint8_t> single(count), batch(count), parallel(count);
+        std::vector<int8_t> wdl(count);
+        auto row = [&](const char* probe, double s) {
+            std::printf("  %-9s %-28s %10.1f %12.0f\n", name, probe, s * 1e9 / count, count / s);
+        };
+        char label[64];
+        std::snprintf(label, sizeof label, "one at a time, %zu-block cache", cacheBlocks);
+        row(label, seconds([&] {
+            BlockCache cache(cacheBlocks);
+            for (std::size_t i = 0; i < count; ++i) single[i] = probeTablebase(tb, cache, rules, indexer, in[i]);
+        }));
+        row("probeBatch, 1 thread", seconds([&] { probeBatch(tb, rules, indexer, in, count, wdl.data(), batch.data(), 1); }));
+        std::snprintf(label, sizeof label, "probeBatch, %d thread%s", threads, threads == 1 ? "" : "s");
+        row(label, seconds([&] { probeBatch(tb, rules, indexer, in, count, nullptr, parallel.data(), threads); }));
+        for (std::size_t i = 0; i < count; ++i)
+            if (single[i] != batch[i] || single[i] != parallel[i] || wdl[i] != wdlOf(single[i])) {
+                std::printf("Position %zu of %s: %s one at a time, %s batched, %s on %d threads\n", i, name,
+                            valueName(single[i]).c_str(), valueName(batch[i]).c_str(), valueName(parallel[i]).c_str(), threads);
+                status = 1;
+                break;
+            }
+    }
+    return status;
+}
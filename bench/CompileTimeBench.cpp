@@ -0,0 +1,98 @@
+/*
+Compile-time benchmark - the constexpr Three Men's Morris table against the runtime solve
+
+Build: g++ -std=c++17 -O2 -pthread bench/CompileTimeBench.cpp -o CompileTimeBench
+Usage: CompileTimeBench <boards/three.txt> <scratch dir>
+
+Solves the board with RetrogradeSolver into the scratch directory and checks
+every legal position against kThreeMensMorrisTable (CompileTimeSolve.hpp), and
+checks that the illegal ones are marked unknown. Then times the runtime solve
+the table replaces, and a probe of every position through both.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include "../engine/CompileTimeSolve.hpp"
+#include "../engine/Retrograde.hpp"
+
+template <typename F>
+double nsPerOp(long ops, F&& body) {
+    auto begin = std::chrono::steady_clock::now();
+    body();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / ops;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::fprintf(stderr, "Usage: %s <boards/three.txt> <scratch dir>\n", argv[0]);
+        return 2;
+    }
+    Topology topology;
+    Rules32 rules;
+    std::string error;
+    if (!loadTopology(argv[1], topology, error) || !compileTopology(topology, rules, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    if (rules.points != kTmmPoints || rules.men != kTmmMen) {
+        std::fprintf(stderr, "%s is not Three Men's Morris\n", argv[1]);
+        return 1;
+    }
+    PositionIndexer<uint32_t> indexer(rules);
+    RetrogradeSolver<uint32_t> solver(rules, indexer, argv[2], 1);
+    std::remove((std::string(argv[2]) + "/progress.txt").c_str()); // Solve from scratch, to time it
+    auto begin = std::chrono::steady_clock::now();
+    if (!solver.solve(false, error, [](const std::string&) {})) {
+        std::fprintf(stderr, "Solve failed: %s\n", error.c_str());
+        return 1;
+    }
+    double solveMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    // Every base-3 index, as a position with Player A or B to move as the token counts say
+    std::vector<Position32> positions;
+    long legal = 0, wrong = 0;
+    for (int index = 0; index < kTmmPositions; ++index) {
+        Position32 pos;
+        uint32_t mine = 0, theirs = 0;
+        for (int p = 0, rest = index; p < kTmmPoints; ++p, rest /= 3) {
+            if (rest % 3 == 1) mine |= 1u << p;
+            if (rest % 3 == 2) theirs |= 1u << p;
+        }
+        int m = __builtin_popcount(mine), t = __builtin_popcount(theirs);
+        bool isLegal = t <= kTmmMen && (t == m || t == m + 1);
+        uint8_t expected = kUnknown;
+        if (isLegal) {
+            ++legal;
+            pos.turn = t == m ? Player::A : Player::B;
+            int me = static_cast<int>(pos.turn);
+            pos.men[me] = mine;
+            pos.men[1 - me] = theirs;
+            pos.hand[me] = kTmmMen - m;
+            pos.hand[1 - me] = kTmmMen - t;
+            positions.push_back(pos);
+            expected = solver.store().probe(pos);
+        }
+        if (kThreeMensMorrisTable[index] != expected && wrong++ < 5)
+            std::printf("  index %d: %s at compile time, %s at run time\n%s", index,
+                        valueName(kThreeMensMorrisTable[index]).c_str(), valueName(expected).c_str(),
+                        isLegal ? boardDiagram(topology, pos).c_str() : "");
+    }
+    std::printf("%s: %ld legal positions of %d indices, %s\n", topology.name.c_str(), legal, kTmmPositions,
+                wrong ? (std::to_string(wrong) + " MISMATCHES").c_str() : "identical");
+
+    const int rounds = 200;
+    const long probes = static_cast<long>(positions.size()) * rounds;
+    unsigned sink = 0;
+    double table = nsPerOp(probes, [&] {
+        for (int r = 0; r < rounds; ++r)
+            for (const auto& pos : positions) sink += probeThreeMensMorris(pos);
+    });
+    double store = nsPerOp(probes, [&] {
+        for (int r = 0; r < rounds; ++r)
+            for (const auto& pos : positions) sink += solver.store().probe(pos);
+    });
+    std::printf("  runtime solve  %8.2f ms, the constexpr table needs none\n", solveMs);
+    std::printf("  probe          %8.2f ns constexpr table, %.2f ns TableStore  (%u)\n", table, store, sink & 1);
+    return wrong ? 1 : 0;
+}
@@ -0,0 +1,101 @@
+/*
+K-in-a-row benchmark - shift-and-AND line detection against a cell scan
+
+Build: g++ -std=c++17 -O2 bench/KInARowBench.cpp -o KInARowBench
+Runs 3x3 (K=3), 7x7 (K=4) and 15x15 (K=5) boards. For each it times line
+detection on random boards with the bitboard engine and with a plain cell
+scan, checks that both agree, and measures random placement + slide playouts.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "../engine/KInARow.hpp"
+
+// Reference line detection: walks every cell in every direction
+template <int N, int K>
+bool hasLineNaive(const std::array<std::array<bool, N>, N>& grid) {
+    static const int dirs[4][2] = {{0, 1}, {1, 0}, {1, 1}, {1, -1}};
+    for (int r = 0; r < N; ++r)
+        for (int c = 0; c < N; ++c)
+            for (const auto& d : dirs) {
+                int k = 0;
+                while (k < K) {
+                    int rr = r + d[0] * k, cc = c + d[1] * k;
+                    if (rr < 0 || rr >= N || cc < 0 || cc >= N || !grid[rr][cc]) break;
+                    ++k;
+                }
+                if (k == K) return true;
+            }
+    return false;
+}
+
+template <typename F>
+double nsPerOp(long ops, F&& body) {
+    auto begin = std::chrono::steady_clock::now();
+    body();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / ops;
+}
+
+template <int N, int K>
+bool run(int men) {
+    using Game = KInARow<N, K>;
+    Game game(men);
+    std::mt19937 rng(N * 100 + K);
+
+    // Random boards with roughly one cell in three occupied
+    const int boards = 4096;
+    std::vector<typename Game::Bitboard> bits(boards);
+    std::vector<std::array<std::array<bool, N>, N>> grids(boards);
+    for (int i = 0; i < boards; ++i)
+        for (int r = 0; r < N; ++r)
+            for (int c = 0; c < N; ++c) {
+                bool on = rng() % 3 == 0;
+                grids[i][r][c] = on;
+                if (on) bits[i].set(Game::cell(r, c));
+            }
+
+    for (int i = 0; i < boards; ++i) {
+        if (Game::hasLine(bits[i]) != hasLineNaive<N, K>(grids[i])) {
+            std::printf("%dx%d K=%d: bitboard and cell scan disagree on board %d\n", N, N, K, i);
+            return false;
+        }
+    }
+
+    const int rounds = 200;
+    long found = 0;
+    double bitNs = nsPerOp(long(boards) * rounds, [&] {
+        for (int r = 0; r < rounds; ++r)
+            for (int i = 0; i < boards; ++i) found += Game::hasLine(bits[i]);
+    });
+    double naiveNs = nsPerOp(long(boards) * rounds, [&] {
+        for (int r = 0; r < rounds; ++r)
+            for (int i = 0; i < boards; ++i) found += hasLineNaive<N, K>(grids[i]);
+    });
+
+    // Random playouts: placement then slides, capped at 200 plies
+    const int games = 2000;
+    long plies = 0;
+    typename Game::Move moves[Game::kMaxMoves];
+    double plyNs = nsPerOp(1, [&] {
+        for (int g = 0; g < games; ++g) {
+            auto pos = game.start();
+            for (int ply = 0; ply < 200 && !game.isLost(pos); ++ply, ++plies) {
+                int n = game.generateMoves(pos, moves);
+                if (n == 0) break;
+                pos = Game::applyMove(pos, moves[rng() % n]);
+            }
+        }
+    });
+
+    std::printf("%2dx%-2d K=%d  %3d-bit  line check: bitboard %7.2f ns  scan %8.2f ns  (x%.1f)  playout: %6.1f ns/ply  lines %.0f%%\n",
+                N, N, K, Game::kWords * 64, bitNs, naiveNs, naiveNs / bitNs, plyNs / plies, 100.0 * found / (2.0 * boards * rounds));
+    return true;
+}
+
+int main() {
+    bool ok = run<3, 3>(3) && run<7, 7 - 3>(6) && run<15, 5>(12);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,63 @@
+#!/bin/sh
+# PGO benchmark - the profile-guided LTO game against a plain -O2 build
+#
+# Usage: bench/PgoBench.sh [runs] [recording.rec ...]   (default: 5 runs)
+# Run from the repository root; CXX, CXXFLAGS and LIBS as for tools/BuildPgo.sh.
+#
+# Builds both binaries into pgo/ (the PGO one trained on the recordings too),
+# then runs each workload headless with both, alternating, and prints the
+# median wall time and the speedup. Self-play uses a different seed from the
+# training, so the benchmark does not replay the profile's own games. Both
+# binaries must end every workload in the same state.
+
+set -e
+CXX=${CXX:-g++}
+LIBS=${LIBS--lsfml-graphics -lsfml-window -lsfml-system}
+RUNS=${1:-5}
+[ $# -gt 0 ] && shift
+GAMES=${GAMES:-2000}
+
+mkdir -p pgo
+echo "Plain -O2 build"
+$CXX -std=c++17 -O2 $CXXFLAGS ThreeMensMorris.cpp -o pgo/ThreeMensMorris-O2 $LIBS
+tools/BuildPgo.sh pgo/ThreeMensMorris-pgo "$@" > /dev/null
+
+# Prints "<seconds> <state hash>" for one run.
+measure() {
+    "$@" --headless | sed -n 's/.* in \([0-9.]*\)s.*final state \([0-9a-f]*\).*/\1 \2/p'
+}
+
+median() {
+    sort -n | awk '{ v[NR] = $1 } END { print (NR % 2) ? v[(NR + 1) / 2] : (v[NR / 2] + v[NR / 2 + 1]) / 2 }'
+}
+
+bench() {
+    label=$1
+    shift
+    : > pgo/plain.times
+    : > pgo/pgo.times
+    i=0
+    while [ $i -lt "$RUNS" ]; do
+        plain=$(measure pgo/ThreeMensMorris-O2 "$@")
+        pgo=$(measure pgo/ThreeMensMorris-pgo "$@")
+        if [ -z "$plain" ] || [ "${plain#* }" != "${pgo#* }" ]; then
+            echo "$label: final states differ ($plain / $pgo)" >&2
+            exit 1
+        fi
+        echo "${plain% *}" >> pgo/plain.times
+        echo "${pgo% *}" >> pgo/pgo.times
+        i=$((i + 1))
+    done
+    plainMedian=$(median < pgo/plain.times)
+    pgoMedian=$(median < pgo/pgo.times)
+    awk -v l="$label" -v a="$plainMedian" -v b="$pgoMedian" \
+        'BEGIN { printf "%-28s %9.3fs %9.3fs %8s\n", l, a, b, (b > 0) ? sprintf("%.2fx", a / b) : "-" }'
+}
+
+printf "%-28s %10s %10s %8s\n" "workload (median of $RUNS)" "-O2" "PGO+LTO" "speedup"
+for board in boards/*.txt; do
+    bench "self-play $(basename "$board" .txt)" "$board" --self-play "$GAMES" --seed 2
+done
+for recording in "$@"; do
+    bench "playback $(basename "$recording")" --play "$recording"
+done
@@ -0,0 +1,128 @@
+/*
+Ranking benchmark - table-driven rank/unrank against the bit-by-bit versions
+
+Build: g++ -std=c++17 -O2 bench/RankingBench.cpp -o RankingBench
+Usage: RankingBench [board.txt ...]   (default: boards/nine.txt)
+
+For each board, times subset rank and unrank with CombinationRanker and with
+rankMask/unrankMask, and full position index/position with and without the
+board symmetries, on random positions of the largest movement partition.
+Every random position is also round-tripped and the counts are checked.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "../engine/Ranking.hpp"
+
+template <typename F>
+double nsPerOp(long ops, F&& body) {
+    auto begin = std::chrono::steady_clock::now();
+    body();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / ops;
+}
+
+bool run(const char* path) {
+    Topology topology;
+    Rules32 rules;
+    std::string error;
+    if (!loadTopology(path, topology, error) || !compileTopology(topology, rules, error)) {
+        std::printf("%s\n", error.c_str());
+        return false;
+    }
+    auto built = std::chrono::steady_clock::now();
+    PositionIndexer<uint32_t> symmetric(rules);
+    double buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - built).count();
+    PositionIndexer<uint32_t> plain(rules, false);
+    const CombinationRanker<uint32_t>& ranker = plain.ranker();
+
+    // The largest partition with both sides on the board
+    PartitionKey key{rules.men, 0, rules.men, 0};
+    while (key.stmMen + key.oppMen > rules.points) --key.stmMen, --key.oppMen;
+    int k = key.stmMen;
+
+    const int samples = 1 << 16;
+    std::mt19937_64 rng(rules.points);
+    std::vector<uint32_t> subsets(samples), stm(samples), opp(samples);
+    std::vector<uint64_t> ranks(samples), indices(samples);
+    for (int i = 0; i < samples; ++i) {
+        ranks[i] = rng() % binomial(rules.points, k);
+        subsets[i] = unrankMask<uint32_t>(ranks[i], k);
+        indices[i] = rng() % plain.size(key);
+        plain.position(key, indices[i], stm[i], opp[i]);
+    }
+
+    for (int i = 0; i < samples; ++i) {
+        uint32_t s, o;
+        if (ranker.rank(subsets[i]) != ranks[i] || ranker.unrank(ranks[i], k) != subsets[i] ||
+            plain.index(key, stm[i], opp[i]) != indices[i]) {
+            std::printf("%s: round trip failed for sample %d\n", topology.name.c_str(), i);
+            return false;
+        }
+        uint64_t index = symmetric.index(key, stm[i], opp[i]);
+        symmetric.position(key, index, s, o);
+        if (symmetric.index(key, s, o) != index) {
+            std::printf("%s: symmetric round trip failed for sample %d\n", topology.name.c_str(), i);
+            return false;
+        }
+    }
+
+    const int rounds = 50;
+    const long ops = long(samples) * rounds;
+    uint64_t sink = 0;
+    double rankRef = nsPerOp(ops, [&] {
+        for (int r = 0; r < rounds; ++r)
+            for (int i = 0; i < samples; ++i) sink += rankMask(subsets[i]);
+    });
+    double rankLut = nsPerOp(ops, [&] {
+        for (int r = 0; r < rounds; ++r)
+            for (int i = 0; i < samples; ++i) sink += ranker.rank(subsets[i]);
+    });
+    double unrankRef = nsPerOp(ops, [&] {
+        for (int r = 0; r < rounds; ++r)
+            for (int i = 0; i < samples; ++i) sink += unrankMask<uint32_t>(ranks[i], k);
+    });
+    double unrankLut = nsPerOp(ops, [&] {
+        for (int r = 0; r < rounds; ++r)
+            for (int i = 0; i < samples; ++i) sink += ranker.unrank(ranks[i], k);
+    });
+    auto indexNs = [&](const PositionIndexer<uint32_t>& indexer) {
+        return nsPerOp(ops, [&] {
+            for (int r = 0; r < rounds; ++r)
+                for (int i = 0; i < samples; ++i) sink += indexer.index(key, stm[i], opp[i]);
+        });
+    };
+    auto positionNs = [&](const PositionIndexer<uint32_t>& indexer) {
+        uint64_t size = indexer.size(key);
+        return nsPerOp(ops, [&] {
+            uint32_t s, o;
+            for (int r = 0; r < rounds; ++r)
+                for (int i = 0; i < samples; ++i) {
+                    indexer.position(key, indices[i] % size, s, o);
+                    sink += s ^ o;
+                }
+        });
+    };
+    double indexPlain = indexNs(plain), indexSym = indexNs(symmetric);
+    double positionPlain = positionNs(plain), positionSym = positionNs(symmetric);
+
+    std::printf("%s, partition %s (%d symmetries, tables built in %.2fs)\n", topology.name.c_str(), key.name().c_str(),
+                symmetric.symmetries(), buildSeconds);
+    std::printf("  subset rank      %6.1f ns bit by bit   %6.1f ns tables  (%.1fx)\n", rankRef, rankLut, rankRef / rankLut);
+    std::printf("  subset unrank    %6.1f ns bit by bit   %6.1f ns tables  (%.1fx)\n", unrankRef, unrankLut, unrankRef / unrankLut);
+    std::printf("  position index   %6.1f ns plain        %6.1f ns symmetric\n", indexPlain, indexSym);
+    std::printf("  index position   %6.1f ns plain        %6.1f ns symmetric\n", positionPlain, positionSym);
+    std::printf("  partition size   %llu plain, %llu symmetric (%.1fx smaller)%s\n",
+                static_cast<unsigned long long>(plain.size(key)), static_cast<unsigned long long>(symmetric.size(key)),
+                double(plain.size(key)) / symmetric.size(key), sink ? "" : " ");
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    bool ok = true;
+    if (argc < 2) ok = run("boards/nine.txt");
+    for (int i = 1; i < argc; ++i) ok = run(argv[i]) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+/*
+Retrograde benchmark - layered solve against the in-memory solvers
+
+Build: g++ -std=c++17 -O2 -pthread bench/RetrogradeBench.cpp -o RetrogradeBench
+Usage: RetrogradeBench <board.txt> <scratch dir> [--threads N] [--movement-only]
+
+Solves the board once with the layered solver, then with ParallelRetrograde
+(backward) and BitslicedRetrograde (bitsliced) on 1, 2, 4, ... N threads,
+each into its own subdirectory of the scratch directory. Every partition file
+of every in-memory solve is compared byte for byte with the layered one, and
+the time and speedup of each run is reported.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "../engine/BitslicedRetrograde.hpp"
+
+// Solves into 'dir' and returns the time taken in seconds, or a negative value on failure
+double timedSolve(const Rules32& rules, const PositionIndexer<uint32_t>& indexer, const std::string& dir,
+                  int threads, bool movementOnly, const std::string& method) {
+    RetrogradeSolver<uint32_t> solver(rules, indexer, dir, threads);
+    ParallelRetrograde<uint32_t> backward(rules, indexer, solver.store(), threads);
+    BitslicedRetrograde<uint32_t> sliced(rules, indexer, solver.store(), threads);
+    if (method == "backward")
+        solver.setCyclicSolver([&](const std::vector<PartitionKey>& group, const std::vector<uint8_t*>& values,
+                                   std::string& err) { return backward.solve(group, values, err); });
+    if (method == "bitsliced")
+        solver.setCyclicSolver([&](const std::vector<PartitionKey>& group, const std::vector<uint8_t*>& values,
+                                   std::string& err) { return sliced.solve(group, values, err); });
+    std::remove((dir + "/progress.txt").c_str()); // Solve from scratch, not from an earlier run
+    std::string error;
+    auto begin = std::chrono::steady_clock::now();
+    if (!solver.solve(movementOnly, error, [](const std::string&) {})) {
+        std::printf("%s: %s\n", dir.c_str(), error.c_str());
+        return -1;
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// Compares every partition of two solves, reporting the first difference
+bool sameTables(const Rules32& rules, const PositionIndexer<uint32_t>& indexer, const std::string& a,
+                const std::string& b, bool movementOnly) {
+    TableStore<uint32_t> left(rules, indexer, a), right(rules, indexer, b);
+    for (const auto& group : solveOrder(rules, movementOnly))
+        for (const auto& key : group) {
+            const uint8_t* x = left.values(key);
+            const uint8_t* y = right.values(key);
+            if (!x || !y) {
+                std::printf("  %s is missing\n", key.name().c_str());
+                return false;
+            }
+            for (uint64_t i = 0; i < indexer.size(key); ++i)
+                if (x[i] != y[i]) {
+                    std::printf("  %s[%llu]: %d layered, %d in memory\n", key.name().c_str(),
+                                static_cast<unsigned long long>(i), x[i], y[i]);
+                    return false;
+                }
+        }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::fprintf(stderr, "Usage: %s <board.txt> <scratch dir> [--threads N] [--movement-only]\n", argv[0]);
+        return 2;
+    }
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    bool movementOnly = false;
+    for (int i = 3; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) threads = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--movement-only")) movementOnly = true;
+        else {
+            std::fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    threads = std::max(1, threads);
+
+    Topology topology;
+    Rules32 rules;
+    std::string error;
+    if (!loadTopology(argv[1], topology, error) || !compileTopology(topology, rules, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    PositionIndexer<uint32_t> indexer(rules);
+    const std::string scratch = argv[2];
+    mkdir(scratch.c_str(), 0755);
+
+    std::printf("%s%s\n", topology.name.c_str(), movementOnly ? ", movement phase" : "");
+    double layered = timedSolve(rules, indexer, scratch + "/layered", threads, movementOnly, "layered");
+    if (layered < 0) return 1;
+    std::printf("  layered    %2d threads %8.2fs\n", threads, layered);
+
+    bool ok = true;
+    for (const std::string method : {"backward", "bitsliced"}) {
+        double single = 0;
+        for (int t = 1;; t = std::min(threads, t * 2)) {
+            std::string dir = scratch + "/" + method + std::to_string(t);
+            double seconds = timedSolve(rules, indexer, dir, t, movementOnly, method);
+            if (seconds < 0) return 1;
+            if (t == 1) single = seconds;
+            bool same = sameTables(rules, indexer, scratch + "/layered", dir, movementOnly);
+            ok = ok && same;
+            std::printf("  %-10s %2d threads %8.2fs  %5.2fx over 1 thread  %5.2fx over layered  %s\n", method.c_str(), t,
+                        seconds, single / seconds, layered / seconds, same ? "identical" : "MISMATCH");
+            if (t == threads) break;
+        }
+    }
+    return ok ? 0 : 1;
+}
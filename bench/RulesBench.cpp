@@ -0,0 +1,325 @@
+/*
+Rules benchmark - the game's hot paths, in their original and current forms
+
+Build: g++ -std=c++17 -O2 -pthread bench/RulesBench.cpp -o RulesBench
+Usage: RulesBench [board.txt] [--tables dir] [--tablebase file.tb] [--repeat N] [--json out.json]
+       (default board: boards/three.txt)
+
+Times, in ns per operation over positions sampled from random games:
+  - mill detection and adjacency as the original 3x3 game had them (prime
+    products from computeWinProducts tested by checkWin, neighbour lists
+    scanned by isAdjacent) against the bitmask tables that replaced them
+    (hasMill, formsMill, Rules::adjacent); on 9-point boards only;
+  - getFreeSlotUnderMouse as the game had it (every slot against every
+    token) against the SlotGrid lookup with an occupancy mask, on random clicks;
+  - generateMoves, and Zobrist hashing from scratch against updateHash;
+  - probes of the constexpr Three Men's Morris table, of solved tables
+    (--tables, TableStore) and of a tablebase (--tablebase, 256-block cache).
+Each case runs N times (default 15) and the minimum, median, mean and
+standard deviation are printed; --json writes them for tracking over time.
+Old and new forms, hashes and probes are checked to agree on every sample.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "../engine/CompileTimeSolve.hpp"
+#include "../engine/SlotGrid.hpp"
+#include "../engine/Tablebase.hpp"
+
+// --- The original 3x3 game, without SFML --------------------------------------------------
+
+struct LegacyToken {
+    int slotIndex = -1;
+    int nextSlotIndex = -1;
+    Player owner = Player::A;
+    bool moving = false;
+};
+
+const int kLegacyPrimes[9] = {13, 3, 23, 17, 11, 5, 29, 7, 19};
+const std::array<std::array<int, 3>, 8> kLegacyCombos = {{{{0, 1, 2}}, {{3, 4, 5}}, {{6, 7, 8}}, {{0, 3, 6}},
+                                                          {{1, 4, 7}}, {{2, 5, 8}}, {{0, 4, 8}}, {{2, 4, 6}}}};
+
+bool legacyIsAdjacent(int a, int b) {
+    static const std::array<std::vector<int>, 9> adjacent = {{
+        {1, 3, 4}, {0, 2, 4}, {1, 5, 4}, {0, 4, 6}, {0, 1, 2, 3, 5, 6, 7, 8}, {2, 4, 8}, {3, 4, 7}, {6, 4, 8}, {4, 5, 7}
+    }};
+    for (int n : adjacent[a])
+        if (n == b) return true;
+    return false;
+}
+
+std::vector<int> legacyWinProducts() {
+    std::vector<int> products;
+    for (const auto& combo : kLegacyCombos)
+        products.push_back(kLegacyPrimes[combo[0]] * kLegacyPrimes[combo[1]] * kLegacyPrimes[combo[2]]);
+    return products;
+}
+
+bool legacyCheckWin(const std::vector<LegacyToken>& tokens, Player player, const std::vector<int>& winProducts) {
+    int product = 1;
+    for (const auto& t : tokens)
+        if (t.owner == player && t.slotIndex != -1) product *= kLegacyPrimes[t.slotIndex];
+    for (int p : winProducts)
+        if (product % p == 0) return true;
+    return false;
+}
+
+// getFreeSlotUnderMouse as ThreeMensMorris.cpp had it, with sf::FloatRect::contains spelled out
+int freeSlotUnderMouse(const Topology& topology, float x, float y, const std::vector<LegacyToken>& tokens) {
+    for (int i = 0; i < static_cast<int>(topology.points.size()); ++i) {
+        float left = topology.points[i].x - 25, top = topology.points[i].y - 25;
+        bool occupied = false;
+        for (const auto& t : tokens)
+            if (t.slotIndex == i || (t.moving && t.nextSlotIndex == i)) occupied = true;
+        if (!occupied && x >= left && x < left + 50 && y >= top && y < top + 50) return i;
+    }
+    return -1;
+}
+
+// --- Measurement ----------------------------------------------------------------------------
+
+struct Result {
+    std::string name;
+    long ops;
+    double min, median, mean, stddev; // ns per op over the repetitions
+};
+
+unsigned long long sink = 0; // Keeps the measured work alive
+
+template <typename F>
+Result measure(const std::string& name, int repeat, long ops, F&& body) {
+    body(); // Warm up
+    std::vector<double> ns;
+    for (int r = 0; r < repeat; ++r) {
+        auto begin = std::chrono::steady_clock::now();
+        body();
+        auto end = std::chrono::steady_clock::now();
+        ns.push_back(std::chrono::duration<double, std::nano>(end - begin).count() / ops);
+    }
+    std::sort(ns.begin(), ns.end());
+    double mean = 0, var = 0;
+    for (double v : ns) mean += v / ns.size();
+    for (double v : ns) var += (v - mean) * (v - mean) / ns.size();
+    double median = ns.size() % 2 ? ns[ns.size() / 2] : (ns[ns.size() / 2 - 1] + ns[ns.size() / 2]) / 2;
+    Result r{name, ops, ns.front(), median, mean, std::sqrt(var)};
+    std::printf("  %-34s %9.2f %9.2f %9.2f %8.2f\n", name.c_str(), r.min, r.median, r.mean, r.stddev);
+    return r;
+}
+
+bool writeJson(const std::string& path, const std::string& board, int repeat, const std::vector<Result>& results) {
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) return false;
+    std::fprintf(f, "{\n  \"board\": \"%s\",\n  \"compiler\": \"%s\",\n  \"repeat\": %d,\n  \"unit\": \"ns/op\",\n  \"results\": [\n",
+                 board.c_str(), __VERSION__, repeat);
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        std::fprintf(f, "    {\"name\": \"%s\", \"ops\": %ld, \"min\": %.3f, \"median\": %.3f, \"mean\": %.3f, \"stddev\": %.3f}%s\n",
+                     r.name.c_str(), r.ops, r.min, r.median, r.mean, r.stddev, i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    return std::fclose(f) == 0;
+}
+
+// A position from a random game, the move played from it and the game's tokens for it
+struct Sample {
+    Position32 pos;
+    Move move;
+    std::vector<LegacyToken> tokens;
+};
+
+std::vector<Sample> randomSamples(const Rules32& rules, std::size_t count, std::mt19937& rng) {
+    std::vector<Sample> samples;
+    Move moves[kMaxMoves];
+    while (samples.size() < count) {
+        Position32 pos = startPosition(rules);
+        for (int ply = 0; ply < 200 && samples.size() < count && !isLost(rules, pos); ++ply) {
+            int n = generateMoves(rules, pos, moves);
+            if (n == 0) break;
+            Sample s{pos, moves[rng() % n], {}};
+            for (int p = 0; p < 2; ++p)
+                for (uint32_t m = pos.men[p]; m; m &= m - 1) {
+                    LegacyToken t;
+                    t.slotIndex = lowestPoint(m);
+                    t.owner = static_cast<Player>(p);
+                    s.tokens.push_back(t);
+                }
+            samples.push_back(s);
+            pos = applyMove(pos, s.move);
+        }
+    }
+    return samples;
+}
+
+int main(int argc, char* argv[]) {
+    std::string board = "boards/three.txt", tablesDir, tablebasePath, jsonPath;
+    int repeat = 15;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--tables") && i + 1 < argc) tablesDir = argv[++i];
+        else if (!std::strcmp(argv[i], "--tablebase") && i + 1 < argc) tablebasePath = argv[++i];
+        else if (!std::strcmp(argv[i], "--repeat") && i + 1 < argc) repeat = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--json") && i + 1 < argc) jsonPath = argv[++i];
+        else if (argv[i][0] != '-') board = argv[i];
+        else {
+            std::fprintf(stderr, "Usage: %s [board.txt] [--tables dir] [--tablebase file.tb] [--repeat N] [--json out.json]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    Topology topology;
+    Rules32 rules;
+    std::string error;
+    if (!loadTopology(board, topology, error) || !compileTopology(topology, rules, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    PositionIndexer<uint32_t> indexer(rules);
+    std::mt19937 rng(12345);
+    const std::vector<Sample> samples = randomSamples(rules, 4096, rng);
+    const long n = static_cast<long>(samples.size());
+    const int rounds = 32;
+    const long ops = n * rounds;
+    bool ok = true;
+    auto check = [&ok](bool agree, const char* what) {
+        if (!agree && ok) std::printf("  MISMATCH: %s\n", what);
+        ok = ok && agree;
+    };
+
+    std::printf("%s: %ld sampled positions, %d repetitions\n", topology.name.c_str(), n, repeat);
+    std::printf("  %-34s %9s %9s %9s %8s  (ns/op)\n", "", "min", "median", "mean", "stddev");
+    std::vector<Result> results;
+
+    if (rules.points == 9) {
+        const std::vector<int> products = legacyWinProducts();
+        for (const auto& s : samples)
+            for (int p = 0; p < 2; ++p)
+                check(legacyCheckWin(s.tokens, static_cast<Player>(p), products) == hasMill(rules, s.pos.men[p]),
+                      "checkWin and hasMill");
+        for (int a = 0; a < 9; ++a)
+            for (int b = 0; b < 9; ++b) check(legacyIsAdjacent(a, b) == ((rules.adjacent[a] >> b) & 1u), "isAdjacent and Rules::adjacent");
+
+        results.push_back(measure("computeWinProducts", repeat, ops, [&] {
+            for (long i = 0; i < ops; ++i) sink += legacyWinProducts()[i & 7];
+        }));
+        results.push_back(measure("mill masks (compileTopology)", repeat, ops, [&] {
+            for (long i = 0; i < ops; ++i) {
+                std::vector<uint32_t> mills;
+                for (const auto& mill : topology.mills) {
+                    uint32_t m = 0;
+                    for (int p : mill) m |= 1u << p;
+                    mills.push_back(m);
+                }
+                sink += mills[i % mills.size()];
+            }
+        }));
+        results.push_back(measure("checkWin (prime products)", repeat, ops, [&] {
+            for (int r = 0; r < rounds; ++r)
+                for (const auto& s : samples) sink += legacyCheckWin(s.tokens, s.pos.turn, products);
+        }));
+        results.push_back(measure("hasMill (bitmask)", repeat, ops, [&] {
+            for (int r = 0; r < rounds; ++r)
+                for (const auto& s : samples) sink += hasMill(rules, s.pos.men[static_cast<int>(s.pos.turn)]);
+        }));
+        results.push_back(measure("formsMill (mills through a point)", repeat, ops, [&] {
+            for (int r = 0; r < rounds; ++r)
+                for (const auto& s : samples) sink += formsMill(rules, s.pos.men[static_cast<int>(s.pos.turn)], s.move.to);
+        }));
+        results.push_back(measure("isAdjacent (neighbour lists)", repeat, ops, [&] {
+            for (long i = 0; i < ops; ++i) sink += legacyIsAdjacent(i % 9, (i / 9) % 9);
+        }));
+        results.push_back(measure("Rules::adjacent (bitmask)", repeat, ops, [&] {
+            for (long i = 0; i < ops; ++i) sink += (rules.adjacent[i % 9] >> ((i / 9) % 9)) & 1u;
+        }));
+    }
+
+    std::vector<std::array<float, 2>> clicks(samples.size());
+    std::uniform_real_distribution<float> coord(0.f, 600.f);
+    for (auto& c : clicks) c = {coord(rng), coord(rng)};
+    SlotGrid grid;
+    grid.build(topology, 50);
+    std::vector<uint32_t> occupied(samples.size());
+    for (long i = 0; i < n; ++i) {
+        for (const auto& t : samples[i].tokens)
+            occupied[i] |= 1u << t.slotIndex | (t.moving ? 1u << t.nextSlotIndex : 0);
+        check(grid.pointAt(clicks[i][0], clicks[i][1], rules.full & ~occupied[i]) ==
+                  freeSlotUnderMouse(topology, clicks[i][0], clicks[i][1], samples[i].tokens),
+              "getFreeSlotUnderMouse and SlotGrid");
+    }
+    results.push_back(measure("getFreeSlotUnderMouse (scan)", repeat, ops, [&] {
+        for (int r = 0; r < rounds; ++r)
+            for (long i = 0; i < n; ++i) sink += freeSlotUnderMouse(topology, clicks[i][0], clicks[i][1], samples[i].tokens);
+    }));
+    results.push_back(measure("SlotGrid::pointAt (occupancy mask)", repeat, ops, [&] {
+        for (int r = 0; r < rounds; ++r)
+            for (long i = 0; i < n; ++i) sink += grid.pointAt(clicks[i][0], clicks[i][1], rules.full & ~occupied[i]);
+    }));
+
+    Move moves[kMaxMoves];
+    results.push_back(measure("generateMoves", repeat, ops, [&] {
+        for (int r = 0; r < rounds; ++r)
+            for (const auto& s : samples) sink += generateMoves(rules, s.pos, moves);
+    }));
+
+    ZobristKeys<uint32_t> keys;
+    std::vector<uint64_t> hashes(samples.size());
+    for (long i = 0; i < n; ++i) {
+        hashes[i] = hashPosition(keys, samples[i].pos);
+        check(updateHash(keys, hashes[i], samples[i].pos, samples[i].move) ==
+                  hashPosition(keys, applyMove(samples[i].pos, samples[i].move)),
+              "updateHash and hashPosition");
+    }
+    results.push_back(measure("Zobrist hashPosition(applyMove)", repeat, ops, [&] {
+        for (int r = 0; r < rounds; ++r)
+            for (const auto& s : samples) sink += hashPosition(keys, applyMove(s.pos, s.move));
+    }));
+    results.push_back(measure("Zobrist updateHash", repeat, ops, [&] {
+        for (int r = 0; r < rounds; ++r)
+            for (long i = 0; i < n; ++i) sink += updateHash(keys, hashes[i], samples[i].pos, samples[i].move);
+    }));
+
+    // Probes. Every source given is checked against the others on every sample.
+    std::vector<uint8_t> expected(samples.size(), kUnknown);
+    auto agree = [&](uint8_t v, long i, const char* what) {
+        if (expected[i] == kUnknown) expected[i] = v;
+        check(expected[i] == v, what);
+    };
+    if (rules.points == kTmmPoints && rules.men == kTmmMen && rules.capture == CaptureRule::Win) {
+        for (long i = 0; i < n; ++i) agree(probeThreeMensMorris(samples[i].pos), i, "constexpr table probe");
+        results.push_back(measure("probe constexpr table", repeat, ops, [&] {
+            for (int r = 0; r < rounds; ++r)
+                for (const auto& s : samples) sink += probeThreeMensMorris(s.pos);
+        }));
+    }
+    if (!tablesDir.empty()) {
+        TableStore<uint32_t> store(rules, indexer, tablesDir);
+        for (long i = 0; i < n; ++i) agree(store.probe(samples[i].pos), i, "TableStore probe");
+        results.push_back(measure("probe TableStore", repeat, ops, [&] {
+            for (int r = 0; r < rounds; ++r)
+                for (const auto& s : samples) sink += store.probe(s.pos);
+        }));
+    }
+    if (!tablebasePath.empty()) {
+        TablebaseFile tb;
+        if (!tb.open(tablebasePath, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        BlockCache cache(256);
+        for (long i = 0; i < n; ++i) agree(probeTablebase(tb, cache, rules, indexer, samples[i].pos), i, "tablebase probe");
+        results.push_back(measure("probe tablebase", repeat, ops, [&] {
+            for (int r = 0; r < rounds; ++r)
+                for (const auto& s : samples) sink += probeTablebase(tb, cache, rules, indexer, s.pos);
+        }));
+    }
+
+    if (!jsonPath.empty() && !writeJson(jsonPath, topology.name, repeat, results)) {
+        std::fprintf(stderr, "Cannot write %s\n", jsonPath.c_str());
+        return 1;
+    }
+    std::printf("  %s  (%llu)\n", ok ? "all forms agree" : "MISMATCH", sink & 1);
+    return ok ? 0 : 1;
+}
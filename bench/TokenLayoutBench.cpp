@@ -0,0 +1,171 @@
+/*
+Token layout benchmark - game state with sprites inside the tokens, and split from them
+
+Build: g++ -std=c++17 -O2 bench/TokenLayoutBench.cpp -o TokenLayoutBench -lsfml-graphics -lsfml-window -lsfml-system
+Usage: TokenLayoutBench [board.txt] [--games N]   (default: boards/nine.txt, 4096 games)
+
+Before the split, each token was its game fields next to an sf::Sprite in a
+std::vector (LegacyToken). Now TokenStore keeps 8-byte Tokens, and their
+positions and sprite IDs are kept apart in TokenSprites. Prints the bytes per
+token and per game of both, then times the scans the game logic did over the
+tokens (the players' slot masks, the token on a slot, selection state) in
+both layouts, and the lookups that replaced them. Scans run on one game, which
+stays in cache, and across N games of random tokens, as a headless workload
+keeping many games would. Both layouts are checked to give the same answers.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include "../Game.hpp"
+
+// A token as Game.hpp had it before the split
+struct LegacyToken {
+    sf::Sprite sprite;
+    int slotIndex = -1;
+    int nextSlotIndex = -1;
+    Player owner;
+    bool selected = false;
+    bool moving = false;
+};
+
+unsigned long long sink = 0; // Keeps the measured work alive
+
+// Best of five runs of 'body', in ns per call of it per game
+template <typename F>
+double nsPerGame(long games, long rounds, F&& body) {
+    double best = 1e300;
+    for (int run = 0; run < 5; ++run) {
+        auto begin = std::chrono::steady_clock::now();
+        for (long r = 0; r < rounds; ++r) body();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(end - begin).count() / (rounds * games));
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    std::string board = "boards/nine.txt";
+    long games = 4096;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--games" && i + 1 < argc) games = std::max(1L, std::atol(argv[++i]));
+        else if (arg[0] != '-') board = arg;
+        else {
+            std::fprintf(stderr, "Usage: %s [board.txt] [--games N]\n", argv[0]);
+            return 2;
+        }
+    }
+    logFile.close();
+    std::string error;
+    if (!loadTopology(board, topology, error) || !compileTopology(topology, rules, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    // Random games: each player has placed all tokens, a random number of them are left
+    // on random slots, and one of Player A's tokens is selected
+    std::mt19937 rng(1);
+    std::vector<std::vector<LegacyToken>> legacy(games);
+    std::vector<TokenStore> stores(games);
+    std::vector<TokenSprites> sprites(games);
+    std::vector<int> probes(games);
+    for (long g = 0; g < games; ++g) {
+        std::vector<int> slots(rules.points);
+        for (int i = 0; i < rules.points; ++i) slots[i] = i;
+        std::shuffle(slots.begin(), slots.end(), rng);
+        int next = 0;
+        for (int p = 0; p < 2; ++p) {
+            int left = 3 + static_cast<int>(rng() % (rules.men - 2));
+            for (int k = 0; k < left; ++k) {
+                Token t;
+                t.owner = static_cast<Player>(p);
+                t.slotIndex = static_cast<int8_t>(slots[next++]);
+                int h = stores[g].add(t);
+                sprites[g].position[h] = slotPosition(t.slotIndex) - sf::Vector2f(25, 25);
+                sprites[g].sprite[h] = static_cast<uint8_t>(p);
+                LegacyToken l;
+                l.slotIndex = t.slotIndex;
+                l.owner = t.owner;
+                l.sprite.setPosition(sprites[g].position[h]);
+                legacy[g].push_back(l);
+            }
+        }
+        legacy[g][0].selected = stores[g][0].selected = true;
+        probes[g] = static_cast<int>(rng() % rules.points);
+    }
+
+    long bytesLegacy = 0;
+    for (const auto& l : legacy) bytesLegacy += static_cast<long>(sizeof(l) + l.capacity() * sizeof(LegacyToken));
+    std::printf("%s, %ld games\n", topology.name.c_str(), games);
+    std::printf("  bytes per token: %zu with its sprite, now %zu of game state + %zu to draw it\n",
+                sizeof(LegacyToken), sizeof(Token), sizeof(sf::Vector2f) + sizeof(uint8_t));
+    std::printf("  bytes per game:  %.0f in a vector, now %zu in TokenStore + %zu in TokenSprites (fixed, %d tokens)\n",
+                static_cast<double>(bytesLegacy) / games, sizeof(TokenStore), sizeof(TokenSprites), TokenStore::kCapacity);
+
+    // The scans, and their replacements, must agree on every game
+    for (long g = 0; g < games; ++g) {
+        uint32_t men[2] = {0, 0};
+        int onSlot = -1, index = 0, selectedAt = -1;
+        for (const auto& t : legacy[g]) {
+            men[static_cast<int>(t.owner)] |= 1u << t.slotIndex;
+            if (t.slotIndex == probes[g]) onSlot = index;
+            if (t.selected) selectedAt = t.slotIndex;
+            ++index;
+        }
+        int h = stores[g].bySlot[probes[g]];
+        if (men[0] != stores[g].men[0] || men[1] != stores[g].men[1] || onSlot != h || selectedAt != stores[g][0].slotIndex) {
+            std::fprintf(stderr, "Layouts disagree on game %ld\n", g);
+            return 1;
+        }
+    }
+
+    std::printf("  %-46s %10s %10s\n", "ns per game", "1 game", "all games");
+    auto row = [&](const char* name, auto&& scan) {
+        double hot = nsPerGame(1, 2000000 / games + 1000, [&] { scan(0L); });
+        double cold = nsPerGame(games, 20, [&] { for (long g = 0; g < games; ++g) scan(g); });
+        std::printf("  %-46s %10.2f %10.2f\n", name, hot, cold);
+    };
+    row("slot masks, scanning LegacyToken", [&](long g) {
+        uint32_t men[2] = {0, 0};
+        for (const auto& t : legacy[g]) men[static_cast<int>(t.owner)] |= 1u << t.slotIndex;
+        sink += men[0] ^ men[1];
+    });
+    row("slot masks, scanning Token", [&](long g) {
+        uint32_t men[2] = {0, 0};
+        for (const auto& t : stores[g]) men[static_cast<int>(t.owner)] |= 1u << t.slotIndex;
+        sink += men[0] ^ men[1];
+    });
+    row("slot masks, TokenStore::men", [&](long g) { sink += stores[g].men[0] ^ stores[g].men[1]; });
+    row("token on a slot, scanning LegacyToken", [&](long g) {
+        int found = -1, index = 0;
+        for (const auto& t : legacy[g]) {
+            if (t.slotIndex == probes[g]) found = index;
+            ++index;
+        }
+        sink += found;
+    });
+    row("token on a slot, TokenStore::bySlot", [&](long g) { sink += stores[g].bySlot[probes[g]]; });
+    row("selected token, scanning LegacyToken", [&](long g) {
+        for (const auto& t : legacy[g])
+            if (t.selected) sink += t.slotIndex;
+    });
+    row("selected token, scanning Token", [&](long g) {
+        for (const auto& t : stores[g])
+            if (t.selected) sink += t.slotIndex;
+    });
+    row("sprite positions, LegacyToken", [&](long g) {
+        float sum = 0;
+        for (const auto& t : legacy[g]) sum += t.sprite.getPosition().x;
+        sink += static_cast<unsigned long long>(sum);
+    });
+    row("sprite positions, TokenSprites", [&](long g) {
+        float sum = 0;
+        for (uint32_t m = stores[g].used; m; m &= m - 1) sum += sprites[g].position[lowestPoint(m)].x;
+        sink += static_cast<unsigned long long>(sum);
+    });
+    std::printf("(checksum %llu)\n", sink);
+    return 0;
+}
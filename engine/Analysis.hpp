@@ -0,0 +1,234 @@
+/*
+Analysis - reviews a played game, move by move, against perfect play or a search
+
+A position's analysis is its value for the side to move (Values.hpp) and its
+best move. PositionAnalyzer gives them from a table probe at once, or else
+searches for them on a pool of worker threads (Search.hpp). A search that
+proves a forced result within its limits gives the same value a table would;
+any other gives kUnknown ("unclear"). Positions are meant to be submitted as
+they arise, so a game's positions are analyzed while it is being played.
+
+reviewGame() then compares each move's value before and after it. A move that
+turns a win into a draw or a loss, or a draw into a loss, changed the
+theoretical result, and the best move is the alternative. After a search, an
+unclear value counts as a draw before a move but proves nothing after it.
+gameReport() writes the review as text, with a diagram before every move that
+changed the result.
+*/
+
+#pragma once
+
+#include <deque>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include "Search.hpp"
+
+struct PositionAnalysis {
+    uint8_t value = kUnknown; // For the side to move
+    Move best;                // to == -1 if the side to move has no move
+};
+
+// The value a search result proves, or kUnknown
+inline uint8_t searchValue(const SearchResult& r) {
+    return isMateScore(r.score) ? static_cast<uint8_t>(std::min(kMateScore - std::abs(r.score), int(kMaxDistance))) : kUnknown;
+}
+
+// Win (1), draw or unclear (0), or loss (-1) for the side to move
+constexpr int resultClass(uint8_t v) { return isWinValue(v) ? 1 : isLossValue(v) ? -1 : 0; }
+
+inline const char* resultName(uint8_t v) {
+    return isWinValue(v) ? "win" : isLossValue(v) ? "loss" : v == kDraw ? "draw" : "unclear";
+}
+
+template <typename Mask>
+class PositionAnalyzer {
+public:
+    using Probe = std::function<uint8_t(const Position<Mask>&)>;
+
+    PositionAnalyzer(const Rules<Mask>& rules, int threads, double seconds, std::size_t tableEntries = std::size_t(1) << 18)
+        : rules_(rules), threads_(std::max(1, threads)), seconds_(seconds), tableEntries_(tableEntries) {}
+    PositionAnalyzer(const PositionAnalyzer&) = delete;
+    PositionAnalyzer& operator=(const PositionAnalyzer&) = delete;
+
+    ~PositionAnalyzer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            quit_ = true;
+            for (auto& s : stop_) *s = true;
+        }
+        wake_.notify_all();
+        for (auto& w : workers_) w.join();
+    }
+
+    // Positions are then valued by 'probe' (a table: a value for every position) at once,
+    // in submit(), instead of being searched. An empty probe goes back to searching.
+    void setProbe(Probe probe) {
+        clear();
+        std::lock_guard<std::mutex> lock(mutex_);
+        probe_ = std::move(probe);
+    }
+
+    // Queues a position, unless it was analyzed or queued already
+    void submit(const Position<Mask>& pos) {
+        uint64_t key = hashPosition(keys_, pos);
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (results_.count(key) || queued_.count(key)) return;
+        if (probe_) {
+            PositionAnalysis a;
+            a.best = tableMove(rules_, pos, probe_, &a.value);
+            if (a.best.to < 0) a.value = 0;
+            results_.emplace(key, a);
+            return;
+        }
+        queue_.push_back({key, pos});
+        queued_.insert(key);
+        if (workers_.empty())
+            for (int t = 0; t < threads_; ++t) {
+                stop_.push_back(std::make_unique<std::atomic<bool>>(false));
+                workers_.emplace_back([this, t] { run(t); });
+            }
+        lock.unlock();
+        wake_.notify_one();
+    }
+
+    // The analysis of a position, if it is done
+    bool find(const Position<Mask>& pos, PositionAnalysis& out) const {
+        uint64_t key = hashPosition(keys_, pos);
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = results_.find(key);
+        if (it == results_.end()) return false;
+        out = it->second;
+        return true;
+    }
+
+    // Forgets every analysis and abandons the queued and running ones
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++generation_;
+        queue_.clear();
+        queued_.clear();
+        results_.clear();
+        for (auto& s : stop_) *s = true;
+    }
+
+private:
+    struct Job {
+        uint64_t key;
+        Position<Mask> pos;
+    };
+
+    void run(int t) {
+        Searcher<Mask> searcher(rules_, tableEntries_);
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            wake_.wait(lock, [this] { return quit_ || !queue_.empty(); });
+            if (quit_) return;
+            Job job = queue_.front();
+            queue_.pop_front();
+            uint64_t generation = generation_;
+            *stop_[t] = false;
+            SearchLimits limits;
+            limits.seconds = seconds_;
+            limits.stop = stop_[t].get();
+            lock.unlock();
+            SearchResult r = searcher.search(job.pos, limits);
+            lock.lock();
+            if (generation != generation_) continue;
+            queued_.erase(job.key);
+            results_[job.key] = {searchValue(r), r.best};
+        }
+    }
+
+    const Rules<Mask>& rules_;
+    ZobristKeys<Mask> keys_;
+    int threads_;
+    double seconds_;
+    std::size_t tableEntries_;
+    Probe probe_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::vector<std::thread> workers_;
+    std::vector<std::unique_ptr<std::atomic<bool>>> stop_; // Per worker: abandons its search
+    std::deque<Job> queue_;
+    std::unordered_set<uint64_t> queued_;                  // Waiting or being searched
+    std::unordered_map<uint64_t, PositionAnalysis> results_;
+    uint64_t generation_ = 0;                              // Counts clear() calls
+    bool quit_ = false;
+};
+
+// One move of a game, valued for the player who made it
+struct MoveReview {
+    Player mover = Player::A;
+    Move played, best;
+    uint8_t before = kUnknown; // Value of the position the move was made in
+    uint8_t after = kUnknown;  // Value the move kept: that of the position it led to, from the mover's side
+    // A result known to be worse for the mover. A search that proves nothing after the move
+    // shows no change, but a loss it proves counts even after an unclear position.
+    bool changedResult() const { return after != kUnknown && resultClass(after) < resultClass(before); }
+};
+
+// Reviews the moves of a game played from 'start'. Submits every position not analyzed
+// yet and returns false while any is missing; positions where the game is over need none.
+template <typename Mask>
+bool reviewGame(const Rules<Mask>& rules, PositionAnalyzer<Mask>& analyzer, const Position<Mask>& start,
+                const std::vector<Move>& moves, std::vector<MoveReview>& out) {
+    std::vector<PositionAnalysis> found(moves.size() + 1);
+    bool complete = true;
+    Position<Mask> pos = start;
+    for (std::size_t i = 0; i <= moves.size(); ++i) {
+        if (isGameOver(rules, pos)) found[i].value = 0;
+        else if (!analyzer.find(pos, found[i])) {
+            analyzer.submit(pos);
+            complete = complete && analyzer.find(pos, found[i]);
+        }
+        if (i < moves.size()) pos = applyMove(pos, moves[i]);
+    }
+    if (!complete) return false;
+    out.clear();
+    pos = start;
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+        MoveReview r;
+        r.mover = pos.turn;
+        r.played = moves[i];
+        r.best = found[i].best;
+        r.before = found[i].value;
+        r.after = parentValue(found[i + 1].value);
+        out.push_back(r);
+        pos = applyMove(pos, moves[i]);
+    }
+    return true;
+}
+
+// The review as text: a line per move, then a diagram of the position before each move
+// that changed the result
+template <typename Mask>
+std::string gameReport(const Topology& topology, const Position<Mask>& start, const std::vector<Move>& moves,
+                       const std::vector<MoveReview>& review) {
+    std::ostringstream out;
+    int changed[2] = {0, 0};
+    for (const MoveReview& r : review) changed[static_cast<int>(r.mover)] += r.changedResult();
+    out << topology.name << ": " << review.size() << " moves, " << changed[0] << " by Player A and " << changed[1]
+        << " by Player B changed the result\n";
+    char line[160];
+    for (std::size_t i = 0; i < review.size(); ++i) {
+        const MoveReview& r = review[i];
+        std::string result = resultName(r.before);
+        if (r.changedResult()) result += std::string(" -> ") + resultName(r.after);
+        std::snprintf(line, sizeof line, "%3zu. %c %-9s %-16s %s%s\n", i + 1, r.mover == Player::A ? 'A' : 'B',
+                      moveName(r.played).c_str(), result.c_str(), r.changedResult() ? "best " : "",
+                      r.changedResult() ? (moveName(r.best) + " (" + (r.before == kUnknown ? "unclear" : valueName(r.before)) + ")").c_str() : "");
+        out << line;
+    }
+    Position<Mask> pos = start;
+    for (std::size_t i = 0; i < review.size(); ++i) {
+        const MoveReview& r = review[i];
+        if (r.changedResult())
+            out << "\nBefore move " << i + 1 << ", Player " << (r.mover == Player::A ? 'A' : 'B') << " to play "
+                << moveName(r.best) << " instead of " << moveName(r.played) << ":\n" << boardDiagram(topology, pos);
+        pos = applyMove(pos, moves[i]);
+    }
+    return out.str();
+}
@@ -0,0 +1,126 @@
+/*
+BatchProbe - values of many positions at once from a tablebase
+
+probeBatch() takes a contiguous array of positions (Position32 on every board
+up to 32 points) and fills output arrays with a WDL verdict and the value byte
+(Values.hpp) of each, for its side to move. Each stage is a flat loop:
+  1. partition keys from popcounts, and the partition of each in the file;
+  2. canonical indices (PositionIndexer), hence the block and offset;
+  3. the whole batch ordered by block, with a counting sort;
+  4. a group of distinct blocks at a time, the offset index of each prefetched,
+     then its first compressed bytes, then every block decoded once, only as
+     far as its last probed offset, and its values gathered;
+  5. WDL verdicts from the values, in a branch-free loop.
+A one-at-a-time probe decodes a block per cache miss instead, and takes its
+cache misses on the index and the compressed bytes in turn. Batches of
+kBatchParallelMin positions or more share stages 1-2, 4 and 5 between threads,
+a chunk of kBatchChunk positions or a group of blocks at a time. Batches hold
+fewer than 2^32 positions.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <algorithm>
+#include "Tablebase.hpp"
+
+constexpr std::size_t kBatchChunk = 4096;
+constexpr std::size_t kBatchParallelMin = 4 * kBatchChunk;
+
+// Win, draw or loss for the side to move; kWdlUnknown where the tablebase has no value
+constexpr int8_t kWdlWin = 1, kWdlDraw = 0, kWdlLoss = -1, kWdlUnknown = 2;
+
+constexpr int8_t wdlOf(uint8_t v) {
+    return v >= kUnknown ? (v == kDraw ? kWdlDraw : kWdlUnknown) : (v & 1) ? kWdlWin : kWdlLoss;
+}
+
+// Fills wdl[i] and value[i] for positions[i], i < count; either output may be null.
+// Like probeTablebase(), partitions below the minimum token count take unstoredValue()
+// and positions the tablebase does not cover are kUnknown.
+template <typename Mask>
+void probeBatch(const TablebaseFile& tb, const Rules<Mask>& rules, const PositionIndexer<Mask>& indexer,
+                const Position<Mask>* positions, std::size_t count, int8_t* wdl, uint8_t* value, int threads = 1) {
+    constexpr uint64_t kNoBlock = ~uint64_t(0);
+    const uint64_t blockSize = tb.blockSize();
+    const std::size_t chunks = (count + kBatchChunk - 1) / kBatchChunk;
+    threads = count < kBatchParallelMin ? 1 : static_cast<int>(std::min<std::size_t>(std::max(1, threads), chunks));
+    std::vector<uint64_t> where(count); // Block * block size + offset, or kNoBlock
+    std::vector<uint8_t> values(count);
+    auto eachChunk = [&](auto&& body) {
+        std::atomic<std::size_t> next{0};
+        runWorkers(threads, [&](int) {
+            for (std::size_t c; (c = next++) < chunks;)
+                body(c * kBatchChunk, std::min(count, (c + 1) * kBatchChunk));
+        });
+    };
+
+    // 1-2. Partitions, then indices
+    eachChunk([&](std::size_t begin, std::size_t end) {
+        const TablebasePartition* part[kBatchChunk];
+        for (std::size_t i = begin; i < end; ++i) {
+            PartitionKey key = partitionOf(positions[i]);
+            bool stored = isStored(rules, key);
+            part[i - begin] = stored ? tb.find(key) : nullptr;
+            values[i] = stored ? kUnknown : unstoredValue(rules, key);
+            where[i] = kNoBlock;
+        }
+        for (std::size_t i = begin; i < end; ++i) {
+            const TablebasePartition* p = part[i - begin];
+            if (!p) continue;
+            int me = static_cast<int>(positions[i].turn);
+            uint64_t index = indexer.index(p->key, positions[i].men[me], positions[i].men[1 - me]);
+            if (index < p->positions) where[i] = p->firstBlock * blockSize + index; // Else kUnknown, as probeTablebase()
+        }
+    });
+
+    // 3. Positions by block, found once for the whole batch: a counting sort when the batch
+    // is large next to the tablebase, else a comparison sort
+    std::vector<uint32_t> order;
+    order.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+        if (where[i] != kNoBlock) order.push_back(static_cast<uint32_t>(i));
+    std::vector<uint64_t> runs; // Start of each block's positions in 'order', and the end
+    if (order.size() * 8 >= tb.blockCount()) {
+        std::vector<uint32_t> first(tb.blockCount() + 1, 0);
+        for (uint32_t i : order) ++first[where[i] / blockSize + 1];
+        for (uint64_t b = 0; b < tb.blockCount(); ++b) {
+            if (first[b + 1]) runs.push_back(first[b]);
+            first[b + 1] += first[b];
+        }
+        std::vector<uint32_t> sorted(order.size());
+        for (uint32_t i : order) sorted[first[where[i] / blockSize]++] = i;
+        order.swap(sorted);
+    } else {
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return where[a] < where[b]; });
+        for (std::size_t k = 0; k < order.size(); ++k)
+            if (k == 0 || where[order[k]] / blockSize != where[order[k - 1]] / blockSize) runs.push_back(k);
+    }
+    runs.push_back(order.size());
+
+    // 4. Each block decoded once, up to the last offset probed in it, a group of blocks at a
+    // time: the group's index entries are prefetched, then its compressed bytes
+    constexpr std::size_t kGroup = 16;
+    std::size_t blocks = runs.size() - 1;
+    std::atomic<std::size_t> nextGroup{0};
+    runWorkers(blocks < 2 * kGroup ? 1 : threads, [&](int) {
+        std::vector<uint8_t> decoded(blockSize);
+        for (std::size_t g; (g = nextGroup++ * kGroup) < blocks;) {
+            std::size_t end = std::min(blocks, g + kGroup);
+            for (std::size_t r = g; r < end; ++r) tb.prefetchIndex(where[order[runs[r]]] / blockSize);
+            for (std::size_t r = g; r < end; ++r) tb.prefetchData(where[order[runs[r]]] / blockSize);
+            for (std::size_t r = g; r < end; ++r) {
+                uint64_t block = where[order[runs[r]]] / blockSize, last = 0;
+                for (uint64_t k = runs[r]; k < runs[r + 1]; ++k) last = std::max(last, where[order[k]] % blockSize);
+                tb.decode(block, static_cast<uint32_t>(last + 1), decoded.data());
+                for (uint64_t k = runs[r]; k < runs[r + 1]; ++k) values[order[k]] = decoded[where[order[k]] % blockSize];
+            }
+        }
+    });
+
+    // 5. Outputs
+    eachChunk([&](std::size_t begin, std::size_t end) {
+        if (value) std::copy(values.begin() + begin, values.begin() + end, value + begin);
+        if (wdl)
+            for (std::size_t i = begin; i < end; ++i) wdl[i] = wdlOf(values[i]);
+    });
+}
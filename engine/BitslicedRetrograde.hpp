@@ -0,0 +1,242 @@
+/*
+Bit-sliced retrograde - the layered solve, 64 positions per machine word
+
+The test a layer applies to every undecided position is the same:
+
+  - odd layer d:  some child was lost at d - 1 (inside the group), or the
+                  shortest loss among the children outside it is d - 1
+  - even layer d: every child inside the group is won, and the children
+                  outside it are all wins of at most d - 1 plies
+
+(an undecided position whose children are all wins has its longest win at
+d - 1, or it would have been lost on an earlier layer). Every term is a set
+membership, so the sets are kept as bitmaps and the test is run on 64
+consecutive positions at once:
+
+  - the inside children of a word of positions are stored slot-major: slot j
+    of the word holds the j-th child of each of its 64 positions (or a
+    sentinel that is won and never lost), so gathering slot j gives one bit
+    per lane, and lanes drop out as soon as their answer is known;
+  - the layer at which the outside children allow a win or a loss is stored
+    as 8 bit planes per word and compared with d bit by bit, for 64 lanes in
+    a handful of AND/OR operations.
+
+With AVX2, slot gathers fetch 8 lanes per instruction. The gathers are the
+whole cost of a layer, so wider 256-lane words would only change the few
+plane operations around them.
+
+Each word is written by one thread only, and a layer reads only the bitmap
+the other parity writes, so layers run in place without locks. The values
+are the same as the layered solver's, byte for byte.
+*/
+
+#pragma once
+
+#include "ParallelRetrograde.hpp"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Bit-sliced 8-bit numbers: plane k holds bit k of the number in each of 64 lanes
+struct BitPlanes {
+    uint64_t plane[8] = {};
+
+    void set(int lane, uint8_t v) {
+        for (int k = 0; k < 8; ++k) plane[k] |= uint64_t((v >> k) & 1) << lane;
+    }
+
+    // Lanes equal to v
+    uint64_t equal(uint8_t v) const {
+        uint64_t m = ~uint64_t(0);
+        for (int k = 0; k < 8; ++k) m &= ((v >> k) & 1) ? plane[k] : ~plane[k];
+        return m;
+    }
+
+    // Lanes less than or equal to v, from the top bit down
+    uint64_t atMost(uint8_t v) const {
+        uint64_t less = 0, same = ~uint64_t(0);
+        for (int k = 7; k >= 0; --k) {
+            if ((v >> k) & 1) {
+                less |= same & ~plane[k];
+                same &= plane[k];
+            } else {
+                same &= ~plane[k];
+            }
+        }
+        return less | same;
+    }
+};
+
+// Bits of 'bits' at child[lane], for the lanes set in 'lanes'
+inline uint64_t gatherBits(const uint64_t* bits, const uint32_t* child, uint64_t lanes) {
+    uint64_t m = 0;
+#ifdef __AVX2__
+    const int* words = reinterpret_cast<const int*>(bits); // Bit c is bit c % 32 of 32-bit word c / 32
+    const __m256i low = _mm256_set1_epi32(31);
+    for (int group = 0; group < 8; ++group) {
+        if (!((lanes >> (8 * group)) & 0xFF)) continue;
+        __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(child + 8 * group));
+        __m256i word = _mm256_i32gather_epi32(words, _mm256_srli_epi32(index, 5), 4);
+        __m256i top = _mm256_sllv_epi32(word, _mm256_sub_epi32(low, _mm256_and_si256(index, low)));
+        m |= uint64_t(static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(top)))) << (8 * group);
+    }
+    return m & lanes;
+#else
+    for (; lanes; lanes &= lanes - 1) {
+        int lane = __builtin_ctzll(lanes);
+        uint32_t c = child[lane];
+        m |= ((bits[c >> 6] >> (c & 63)) & 1) << lane;
+    }
+    return m;
+#endif
+}
+
+// Solves cyclic (movement) groups in memory, layer by layer on bitmaps. Plug it into
+// RetrogradeSolver with setCyclicSolver(); the child graph of the group is kept in
+// RAM, about 4 bytes per position and child.
+template <typename Mask>
+class BitslicedRetrograde {
+public:
+    BitslicedRetrograde(const Rules<Mask>& rules, const PositionIndexer<Mask>& indexer, TableStore<Mask>& store, int threads)
+        : rules_(rules), layout_(rules, indexer, store), threads_(std::max(1, threads)) {}
+
+    // Fills values[i] for the partitions of 'group' (one or a mirrored pair)
+    bool solve(const std::vector<PartitionKey>& group, const std::vector<uint8_t*>& values, std::string& error) {
+        layout_.assign(group, values);
+        const uint64_t total = layout_.size();
+        if (total >= UINT32_MAX) {
+            error = group[0].name() + " is too large for 32-bit child indices";
+            return false;
+        }
+        const uint64_t words = (total + 63) / 64;
+        const uint32_t sentinel = static_cast<uint32_t>(total);
+
+        // Slot-major child table: each word holds as many slots as its busiest position
+        std::vector<uint64_t> start(words + 1, 0);
+        parallelFor(words, threads_, [&](uint64_t begin, uint64_t end) {
+            uint64_t inside[kMaxMoves];
+            typename GroupLayout<Mask>::Exits exits;
+            for (uint64_t w = begin; w < end; ++w)
+                for (uint64_t g = w * 64; g < std::min(total, w * 64 + 64); ++g)
+                    start[w + 1] = std::max<int64_t>(start[w + 1], expand(g, inside, exits));
+        });
+        for (uint64_t w = 0; w < words; ++w) start[w + 1] = start[w] + start[w + 1] * 64;
+        children_.assign(start[words], sentinel);
+        start_ = std::move(start);
+
+        planes_.assign(words * 2, BitPlanes());
+        undecided_.assign(words + 1, 0);
+        won_.assign(words + 1, 0);
+        lost_.assign(words + 1, 0);
+        won_[sentinel >> 6] |= uint64_t(1) << (sentinel & 63);
+        std::atomic<int> lastExit{0};
+        parallelFor(words, threads_, [&](uint64_t begin, uint64_t end) {
+            uint64_t inside[kMaxMoves];
+            int last = 0;
+            for (uint64_t w = begin; w < end; ++w)
+                for (uint64_t g = w * 64; g < std::min(total, w * 64 + 64); ++g) {
+                    int lane = static_cast<int>(g & 63);
+                    typename GroupLayout<Mask>::Exits exits;
+                    int count = expand(g, inside, exits);
+                    if (count == kDuplicate) continue;
+                    if (count == kTerminal) {
+                        lost_[w] |= uint64_t(1) << lane;
+                        layout_.setValue(g, 0);
+                        continue;
+                    }
+                    undecided_[w] |= uint64_t(1) << lane;
+                    for (int j = 0; j < count; ++j) children_[start_[w] + uint64_t(j) * 64 + lane] = static_cast<uint32_t>(inside[j]);
+                    uint8_t winAt = exits.minLoss != kUnknown ? exits.minLoss + 1 : 255;
+                    uint8_t lossAt = exits.minLoss == kUnknown && !exits.draw ? exits.maxWin + 1 : 255;
+                    planes_[2 * w].set(lane, winAt);
+                    planes_[2 * w + 1].set(lane, lossAt);
+                    if (winAt != 255) last = std::max<int>(last, winAt);
+                    if (lossAt != 255) last = std::max<int>(last, lossAt);
+                }
+            int seen = lastExit;
+            while (seen < last && !lastExit.compare_exchange_weak(seen, last)) {}
+        });
+
+        for (int d = 1;; ++d) {
+            if (d > kMaxDistance) {
+                error = "distances exceed " + std::to_string(kMaxDistance) + " plies";
+                return false;
+            }
+            std::atomic<uint64_t> decided{0};
+            parallelFor(words, threads_, [&](uint64_t begin, uint64_t end) {
+                uint64_t count = 0;
+                for (uint64_t w = begin; w < end; ++w) {
+                    uint64_t hit = layer(w, d);
+                    if (d & 1) {
+                        won_[w] |= hit;
+                    } else {
+                        lost_[w] = hit;
+                    }
+                    undecided_[w] &= ~hit;
+                    for (uint64_t m = hit; m; m &= m - 1) layout_.setValue(w * 64 + __builtin_ctzll(m), static_cast<uint8_t>(d));
+                    count += __builtin_popcountll(hit);
+                }
+                decided += count;
+            });
+            if (decided == 0 && d >= lastExit) break;
+        }
+
+        // Never decided: draws. Slots that index() never produces copy their canonical twin.
+        parallelFor(total, threads_, [&](uint64_t begin, uint64_t end) {
+            for (uint64_t g = begin; g < end; ++g)
+                if ((undecided_[g >> 6] >> (g & 63)) & 1) layout_.setValue(g, kDraw);
+        });
+        parallelFor(total, threads_, [&](uint64_t begin, uint64_t end) {
+            for (uint64_t g = begin; g < end; ++g) {
+                uint64_t canonical = layout_.canonicalIndex(g);
+                if (canonical != g) layout_.setValue(g, layout_.value(canonical));
+            }
+        });
+        std::vector<uint32_t>().swap(children_);
+        std::vector<BitPlanes>().swap(planes_);
+        return true;
+    }
+
+private:
+    static constexpr int kDuplicate = -1; // Slot filled in from its canonical twin
+    static constexpr int kTerminal = -2;  // Lost before moving
+
+    // Number of inside children of g (see GroupLayout::expand), or kDuplicate / kTerminal
+    int expand(uint64_t g, uint64_t* inside, typename GroupLayout<Mask>::Exits& exits) const {
+        if (layout_.canonicalIndex(g) != g) return kDuplicate;
+        Position<Mask> pos = layout_.positionOf(g);
+        Move moves[kMaxMoves];
+        int n = isLost(rules_, pos) ? 0 : generateMoves(rules_, pos, moves);
+        return n ? layout_.expand(pos, moves, n, inside, exits) : kTerminal;
+    }
+
+    // Positions of word w decided on layer d
+    uint64_t layer(uint64_t w, int d) const {
+        uint64_t open = undecided_[w];
+        if (!open) return 0;
+        const uint32_t* slot = &children_[start_[w]];
+        const uint32_t* end = &children_[0] + start_[w + 1];
+        if (d & 1) { // Wins: any child lost on layer d - 1
+            uint64_t hit = open & planes_[2 * w].equal(static_cast<uint8_t>(d));
+            for (uint64_t rest = open & ~hit; rest && slot != end; slot += 64) {
+                hit |= gatherBits(lost_.data(), slot, rest);
+                rest &= ~hit;
+            }
+            return hit;
+        }
+        uint64_t hit = open & planes_[2 * w + 1].atMost(static_cast<uint8_t>(d)); // Losses: every child won
+        for (; hit && slot != end; slot += 64) hit &= gatherBits(won_.data(), slot, hit);
+        return hit;
+    }
+
+    const Rules<Mask>& rules_;
+    GroupLayout<Mask> layout_;
+    int threads_;
+
+    std::vector<uint64_t> start_;     // Per word: first slot in children_
+    std::vector<uint32_t> children_;  // Slot-major inside children, 64 per slot
+    std::vector<BitPlanes> planes_;   // Per word: layer an outside loss wins, layer outside wins allow a loss
+    std::vector<uint64_t> undecided_; // Canonical positions not decided yet
+    std::vector<uint64_t> won_;       // Positions won so far, and the sentinel
+    std::vector<uint64_t> lost_;      // Positions lost on the last even layer
+};
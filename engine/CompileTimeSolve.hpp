@@ -0,0 +1,160 @@
+/*
+Compile-time solve - perfect play for Three Men's Morris baked into the binary
+
+The 3x3 game has only 4030 legal positions, so the whole solve runs in a
+constexpr function (about 1.5 s of compile time with GCC, well inside its
+default constexpr limits) and the result is a constexpr table: perfect play
+with no files to load and nothing to set up at run time. The values are the
+ones RetrogradeSolver writes, distances included.
+
+Without captures, the tokens in hand follow from the tokens on the board,
+so a position is just the side to move's tokens and the opponent's. The
+table is indexed in base 3, one digit per point (0 empty, 1 side to move,
+2 opponent), and holds the usual value encoding (odd distances win, even
+distances lose, kDraw); unreachable combinations hold kUnknown.
+
+The board is written out below rather than read from boards/three.txt;
+bench/CompileTimeBench.cpp checks every entry against the runtime solver
+run on that file.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "Morris.hpp"
+#include "Values.hpp"
+
+constexpr int kTmmPoints = 9;
+constexpr int kTmmMen = 3;
+constexpr int kTmmPositions = 19683; // 3^9
+
+// Neighbours of each point, and the mills, of boards/three.txt
+constexpr uint16_t kTmmAdjacent[kTmmPoints] = {0x01A, 0x015, 0x032, 0x051, 0x1EF, 0x114, 0x098, 0x150, 0x0B0};
+constexpr uint16_t kTmmMills[8] = {0x007, 0x038, 0x1C0, 0x049, 0x092, 0x124, 0x111, 0x054};
+
+constexpr int tmmCount(uint32_t m) {
+    int n = 0;
+    for (; m; m &= m - 1) ++n;
+    return n;
+}
+
+constexpr bool tmmHasMill(uint32_t m) {
+    for (uint16_t mill : kTmmMills)
+        if ((m & mill) == mill) return true;
+    return false;
+}
+
+// Base-3 weight of each set of points: sum of 3^p
+constexpr std::array<uint16_t, 512> tmmWeights() {
+    std::array<uint16_t, 512> w{};
+    for (int m = 0; m < 512; ++m)
+        for (int p = 0, power = 1; p < kTmmPoints; ++p, power *= 3)
+            if ((m >> p) & 1) w[m] += static_cast<uint16_t>(power);
+    return w;
+}
+
+constexpr std::array<uint16_t, 512> kTmmWeights = tmmWeights();
+
+constexpr int tmmIndex(uint32_t stm, uint32_t opp) { return kTmmWeights[stm] + 2 * kTmmWeights[opp]; }
+
+// Solves by backward propagation from the lost positions. The queue hands out
+// positions in the order they were decided, so distances grow one ply at a time
+// and match the layered solve. Only the legal positions are kept, in a compact
+// list, with the parents of each one precomputed.
+constexpr std::array<uint8_t, kTmmPositions> solveThreeMensMorris() {
+    constexpr int kMaxStates = 4096;
+    constexpr int kMaxChildren = 9; // Nine empty points to place on, or 3 tokens x 3 empty points
+    std::array<uint8_t, kTmmPositions> table{};
+    uint16_t id[kTmmPositions] = {}, stm[kMaxStates] = {}, opp[kMaxStates] = {};
+    uint16_t child[kMaxStates * kMaxChildren] = {}, parents[kMaxStates * kMaxChildren] = {};
+    uint16_t parentStart[kMaxStates + 1] = {}, parentEnd[kMaxStates] = {}, queue[kMaxStates] = {};
+    uint8_t value[kMaxStates] = {}, remaining[kMaxStates] = {};
+    int states = 0, head = 0, tail = 0;
+
+    for (uint32_t s = 0; s < 512; ++s) {
+        int ns = tmmCount(s);
+        if (ns > kTmmMen) continue;
+        // Player A to move has placed as many tokens as B, Player B one fewer than A
+        for (uint32_t free = 0x1FFu & ~s, o = free;; o = (o - 1) & free) {
+            int no = tmmCount(o);
+            if (no <= kTmmMen && (no == ns || no == ns + 1)) {
+                id[tmmIndex(s, o)] = static_cast<uint16_t>(states);
+                stm[states] = static_cast<uint16_t>(s);
+                opp[states] = static_cast<uint16_t>(o);
+                ++states;
+            }
+            if (!o) break;
+        }
+    }
+
+    // Children, and the lost positions to start from
+    for (int i = 0; i < states; ++i) {
+        uint32_t s = stm[i], o = opp[i], empty = 0x1FFu & ~(s | o);
+        uint16_t* out = child + i * kMaxChildren;
+        int n = 0;
+        if (!tmmHasMill(o)) { // Otherwise the opponent closed a mill
+            if (tmmCount(s) < kTmmMen) {
+                for (uint32_t e = empty; e; e &= e - 1) out[n++] = id[tmmIndex(o, s | (e & (~e + 1)))];
+            } else {
+                for (uint32_t m = s; m; m &= m - 1) {
+                    uint32_t from = m & (~m + 1);
+                    for (uint32_t t = kTmmAdjacent[tmmCount(from - 1)] & empty; t; t &= t - 1)
+                        out[n++] = id[tmmIndex(o, (s & ~from) | (t & (~t + 1)))];
+                }
+            }
+        }
+        remaining[i] = static_cast<uint8_t>(n);
+        value[i] = n ? kUnknown : 0;
+        if (!n) queue[tail++] = static_cast<uint16_t>(i);
+        for (int c = 0; c < n; ++c) ++parentStart[out[c] + 1];
+    }
+    for (int i = 0; i < states; ++i) parentEnd[i] = parentStart[i + 1] += parentStart[i];
+    for (int i = states - 1; i >= 0; --i)
+        for (int c = 0; c < remaining[i]; ++c) {
+            uint16_t k = child[i * kMaxChildren + c];
+            parents[--parentEnd[k]] = static_cast<uint16_t>(i);
+        }
+
+    // A lost child wins its parents one ply later; a parent whose last child is won is lost
+    while (head < tail) {
+        int k = queue[head++];
+        bool lost = !(value[k] & 1);
+        for (int p = parentStart[k]; p < parentStart[k + 1]; ++p) {
+            int i = parents[p];
+            if (value[i] != kUnknown || (!lost && --remaining[i])) continue;
+            value[i] = static_cast<uint8_t>(value[k] + 1);
+            queue[tail++] = static_cast<uint16_t>(i);
+        }
+    }
+
+    for (int i = 0; i < kTmmPositions; ++i) table[i] = kUnknown;
+    for (int i = 0; i < states; ++i) table[tmmIndex(stm[i], opp[i])] = value[i] == kUnknown ? kDraw : value[i];
+    return table;
+}
+
+constexpr std::array<uint8_t, kTmmPositions> kThreeMensMorrisTable = solveThreeMensMorris();
+
+// Value of a Three Men's Morris position for the side to move
+template <typename Mask>
+constexpr uint8_t probeThreeMensMorris(const Position<Mask>& pos) {
+    int me = static_cast<int>(pos.turn);
+    return kThreeMensMorrisTable[tmmIndex(static_cast<uint32_t>(pos.men[me]), static_cast<uint32_t>(pos.men[1 - me]))];
+}
+
+static_assert(kThreeMensMorrisTable[0] == 9, "Three Men's Morris is a first player win in 9 plies");
+
+// True if 'rules' are the board the table was solved for, so that it can be probed
+template <typename Mask>
+bool isThreeMensMorris(const Rules<Mask>& rules) {
+    // The table is solved without flying, and with no token count that loses (compileTopology()
+    // sets minMen to 0 whenever a mill wins)
+    if (rules.points != kTmmPoints || rules.men != kTmmMen || rules.capture != CaptureRule::Win ||
+        rules.flyAt != 0 || rules.minMen != 0 || rules.mills.size() != sizeof kTmmMills / sizeof kTmmMills[0])
+        return false;
+    for (int p = 0; p < kTmmPoints; ++p)
+        if (rules.adjacent[p] != kTmmAdjacent[p]) return false;
+    for (uint16_t mill : kTmmMills)
+        if (std::find(rules.mills.begin(), rules.mills.end(), Mask(mill)) == rules.mills.end()) return false;
+    return true;
+}
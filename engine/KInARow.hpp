@@ -0,0 +1,206 @@
+/*
+K-in-a-row engine - NxN boards with placement and slide phases
+
+Each player places a fixed number of tokens and then slides them to any of the
+eight neighbouring cells; the first player with K tokens in a row (horizontal,
+vertical or diagonal) wins. Boards are bitboards of 64, 128 or 256 bits laid
+out row by row with one empty guard column, so a line of K tokens is found
+with shifts and ANDs instead of scanning cells. Board size and K are template
+parameters, so the shift amounts are constants and the loops unroll fully.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "Morris.hpp"
+
+// A bitboard of 64 * Words bits. Bit i lives in word i / 64.
+template <int Words>
+struct WideBits {
+    std::array<uint64_t, Words> w{};
+
+    bool any() const {
+        uint64_t acc = 0;
+        #pragma GCC unroll 4
+        for (int i = 0; i < Words; ++i) acc |= w[i];
+        return acc != 0;
+    }
+    int count() const {
+        int n = 0;
+        #pragma GCC unroll 4
+        for (int i = 0; i < Words; ++i) n += __builtin_popcountll(w[i]);
+        return n;
+    }
+    bool test(int bit) const { return (w[bit >> 6] >> (bit & 63)) & 1u; }
+    void set(int bit) { w[bit >> 6] |= uint64_t(1) << (bit & 63); }
+    void reset(int bit) { w[bit >> 6] &= ~(uint64_t(1) << (bit & 63)); }
+    // Index of the lowest set bit of a non-empty bitboard
+    int lowest() const {
+        #pragma GCC unroll 4
+        for (int i = 0; i < Words; ++i)
+            if (w[i]) return i * 64 + __builtin_ctzll(w[i]);
+        return -1;
+    }
+    void clearLowest() {
+        #pragma GCC unroll 4
+        for (int i = 0; i < Words; ++i)
+            if (w[i]) { w[i] &= w[i] - 1; return; }
+    }
+};
+
+template <int Words>
+inline WideBits<Words> operator&(const WideBits<Words>& a, const WideBits<Words>& b) {
+    WideBits<Words> r;
+    #pragma GCC unroll 4
+    for (int i = 0; i < Words; ++i) r.w[i] = a.w[i] & b.w[i];
+    return r;
+}
+
+template <int Words>
+inline WideBits<Words> operator|(const WideBits<Words>& a, const WideBits<Words>& b) {
+    WideBits<Words> r;
+    #pragma GCC unroll 4
+    for (int i = 0; i < Words; ++i) r.w[i] = a.w[i] | b.w[i];
+    return r;
+}
+
+template <int Words>
+inline WideBits<Words> andNot(const WideBits<Words>& a, const WideBits<Words>& b) {
+    WideBits<Words> r;
+    #pragma GCC unroll 4
+    for (int i = 0; i < Words; ++i) r.w[i] = a.w[i] & ~b.w[i];
+    return r;
+}
+
+// Shift towards bit 0 by Shift bits
+template <int Shift, int Words>
+inline WideBits<Words> shiftDown(const WideBits<Words>& a) {
+    constexpr int q = Shift >> 6, s = Shift & 63;
+    WideBits<Words> r;
+    #pragma GCC unroll 4
+    for (int i = 0; i < Words; ++i) {
+        uint64_t lo = i + q < Words ? a.w[i + q] : 0;
+        uint64_t hi = i + q + 1 < Words ? a.w[i + q + 1] : 0;
+        if constexpr (s == 0) r.w[i] = lo;
+        else r.w[i] = (lo >> s) | (hi << (64 - s));
+    }
+    return r;
+}
+
+// Smallest of 64, 128 or 256 bits that holds 'bits'
+constexpr int bitboardWords(int bits) {
+    return bits <= 64 ? 1 : bits <= 128 ? 2 : 4;
+}
+
+// K-in-a-row on an NxN board (N up to 15)
+template <int N, int K>
+struct KInARow {
+    static_assert(N >= 2 && N <= 15, "boards from 2x2 up to 15x15 are supported");
+    static_assert(K >= 2 && K <= N, "K must fit on the board");
+
+    static constexpr int kStride = N + 1; // One guard column stops lines wrapping around rows
+    static constexpr int kBits = N * kStride;
+    static constexpr int kWords = bitboardWords(kBits);
+    static constexpr int kCells = N * N;
+
+    using Bitboard = WideBits<kWords>;
+
+    struct Position {
+        std::array<Bitboard, 2> men{}; // Occupied cells per player, indexed by Player
+        std::array<int, 2> hand{};     // Tokens each player has yet to place
+        Player turn = Player::A;
+    };
+
+    // A move: place (from == -1) or slide from -> to, cells as bit indices
+    struct Move {
+        int16_t from = -1;
+        int16_t to = -1;
+    };
+
+    static constexpr int kMaxMoves = kCells * 8;
+
+    int men;                                  // Tokens each player places
+    Bitboard full;                            // Every cell of the board
+    std::array<Bitboard, kBits> neighbours{}; // The eight neighbours of each cell
+
+    explicit KInARow(int menPerPlayer) : men(menPerPlayer) {
+        for (int r = 0; r < N; ++r)
+            for (int c = 0; c < N; ++c)
+                full.set(cell(r, c));
+        for (int r = 0; r < N; ++r)
+            for (int c = 0; c < N; ++c)
+                for (int dr = -1; dr <= 1; ++dr)
+                    for (int dc = -1; dc <= 1; ++dc) {
+                        int rr = r + dr, cc = c + dc;
+                        if ((dr || dc) && rr >= 0 && rr < N && cc >= 0 && cc < N)
+                            neighbours[cell(r, c)].set(cell(rr, cc));
+                    }
+    }
+
+    static constexpr int cell(int row, int col) { return row * kStride + col; }
+
+    // True if 'b' holds K cells in a row in any direction
+    static bool hasLine(const Bitboard& b) {
+        return (runsOf<1, K>(b) | runsOf<kStride, K>(b) |
+                runsOf<kStride + 1, K>(b) | runsOf<kStride - 1, K>(b)).any();
+    }
+
+    // Cells that start a run of Len tokens in direction D. Runs double in length by
+    // AND-ing with a shifted copy of themselves, so K = 5 takes three shifts, not four.
+    template <int D, int Len>
+    static Bitboard runsOf(const Bitboard& b) {
+        if constexpr (Len == 1) {
+            return b;
+        } else {
+            constexpr int half = highestPowerOfTwoBelow(Len);
+            Bitboard h = runsOf<D, half>(b);
+            return h & shiftDown<D * (Len - half)>(h);
+        }
+    }
+
+    static constexpr int highestPowerOfTwoBelow(int n) {
+        int p = 1;
+        while (p * 2 < n) p *= 2;
+        return p;
+    }
+
+    Position start() const {
+        Position pos;
+        pos.hand = {men, men};
+        return pos;
+    }
+
+    // The side to move has lost if the opponent completed a line
+    bool isLost(const Position& pos) const {
+        return hasLine(pos.men[1 - static_cast<int>(pos.turn)]);
+    }
+
+    // Generates every legal move into 'out' (capacity kMaxMoves); returns the count
+    int generateMoves(const Position& pos, Move* out) const {
+        int me = static_cast<int>(pos.turn);
+        Bitboard empty = andNot(full, pos.men[0] | pos.men[1]);
+        int n = 0;
+        if (pos.hand[me] > 0) {
+            for (Bitboard e = empty; e.any(); e.clearLowest())
+                out[n++] = Move{-1, static_cast<int16_t>(e.lowest())};
+            return n;
+        }
+        for (Bitboard m = pos.men[me]; m.any(); m.clearLowest()) {
+            int from = m.lowest();
+            for (Bitboard t = neighbours[from] & empty; t.any(); t.clearLowest())
+                out[n++] = Move{static_cast<int16_t>(from), static_cast<int16_t>(t.lowest())};
+        }
+        return n;
+    }
+
+    static Position applyMove(const Position& pos, const Move& move) {
+        Position next = pos;
+        int me = static_cast<int>(pos.turn);
+        if (move.from < 0) next.hand[me]--;
+        else next.men[me].reset(move.from);
+        next.men[me].set(move.to);
+        next.turn = opponent(pos.turn);
+        return next;
+    }
+};
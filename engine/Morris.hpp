@@ -0,0 +1,489 @@
+/*
+Morris rules engine - headless board topology, bitmask tables and move rules
+
+Boards are described by a small text file (see the boards/ folder) listing the
+points, the edges between them, the mills and the token/capture rules.
+compileTopology() turns that description into per-point bitmask tables so
+that move generation and mill detection are a handful of AND/OR operations,
+whether the board has 9 points (Three Men's Morris) or 24 (Nine and Twelve
+Men's Morris). Boards use 32-bit masks by default; Rules<uint64_t> is
+available for descriptions with up to 64 points.
+*/
+
+#pragma once
+
+#include <array>
+#include <limits>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <istream>
+#include <algorithm>
+
+enum class Player { A, B }; // Enum to represent players
+
+// Returns the opponent of the given player
+inline Player opponent(Player p) { return p == Player::A ? Player::B : Player::A; }
+
+// What happens when a player closes a mill
+enum class CaptureRule {
+    Win,    // Closing a mill wins the game immediately (Three Men's Morris)
+    Remove  // Closing a mill removes one opponent token (Six, Nine, Twelve Men's Morris)
+};
+
+// A point on the board, in window coordinates of the 600x600 board area
+struct TopologyPoint {
+    float x;
+    float y;
+};
+
+// Board description as loaded from a boards/*.txt file
+struct Topology {
+    std::string name;                      // Display name of the variant
+    std::string image;                     // Optional board artwork; edges are drawn when empty
+    std::vector<TopologyPoint> points;     // Points in index order
+    std::vector<std::array<int, 2>> edges; // Undirected edges a token may slide along
+    std::vector<std::vector<int>> mills;   // Lines of points that form a mill
+    int men = 3;                           // Tokens each player places
+    int minMen = 3;                        // A player with fewer tokens (board + hand) loses
+    int flyAt = 0;                         // Token count at which a player may fly (0 = never)
+    CaptureRule capture = CaptureRule::Win;
+};
+
+// Parses a board description. Lines are "<key> <values...>", '#' starts a comment:
+//   name Nine Men's Morris     image assets/board.png     men 9
+//   min 3                      fly 3                      capture win|remove
+//   point <x> <y>              edge <a> <b>               mill <a> <b> <c> ...
+// Points are numbered in the order they appear.
+inline bool parseTopology(std::istream& in, Topology& topo, std::string& error) {
+    topo = Topology();
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        std::size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::istringstream ls(line);
+        std::string key;
+        if (!(ls >> key)) continue;
+
+        bool ok = true;
+        if (key == "name" || key == "image") {
+            std::string value;
+            std::getline(ls >> std::ws, value);
+            while (!value.empty() && (value.back() == '\r' || value.back() == ' ')) value.pop_back();
+            (key == "name" ? topo.name : topo.image) = value;
+        } else if (key == "men") {
+            ok = static_cast<bool>(ls >> topo.men) && topo.men > 0;
+        } else if (key == "min") {
+            ok = static_cast<bool>(ls >> topo.minMen) && topo.minMen >= 0;
+        } else if (key == "fly") {
+            ok = static_cast<bool>(ls >> topo.flyAt) && topo.flyAt >= 0;
+        } else if (key == "capture") {
+            std::string rule;
+            ls >> rule;
+            if (rule == "win") topo.capture = CaptureRule::Win;
+            else if (rule == "remove") topo.capture = CaptureRule::Remove;
+            else ok = false;
+        } else if (key == "point") {
+            TopologyPoint p;
+            ok = static_cast<bool>(ls >> p.x >> p.y);
+            if (ok) topo.points.push_back(p);
+        } else if (key == "edge") {
+            std::array<int, 2> e;
+            ok = static_cast<bool>(ls >> e[0] >> e[1]);
+            if (ok) topo.edges.push_back(e);
+        } else if (key == "mill") {
+            std::vector<int> mill;
+            int p;
+            while (ls >> p) mill.push_back(p);
+            ok = mill.size() >= 2;
+            if (ok) topo.mills.push_back(mill);
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            error = "line " + std::to_string(lineNo) + ": cannot parse '" + line + "'";
+            return false;
+        }
+    }
+    if (topo.points.empty()) {
+        error = "board has no points";
+        return false;
+    }
+    return true;
+}
+
+// Loads a board description from a file
+inline bool loadTopology(const std::string& path, Topology& topo, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    if (!parseTopology(file, topo, error)) {
+        error = path + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+constexpr int kMaxMillsPerPoint = 4; // Twelve Men's Morris corners sit on 3 mills, the 3x3 centre on 4
+constexpr int kMaxMoves = 1024;      // Upper bound on legal moves, including the removal choice
+
+// Bitmask tables compiled from a Topology. Bit i of a mask is point i.
+template <typename Mask>
+struct Rules {
+    static constexpr int kMaxPoints = std::numeric_limits<Mask>::digits;
+
+    int points = 0;
+    Mask full = 0;                                 // All points of the board
+    std::array<Mask, kMaxPoints> adjacent{};       // Neighbours of each point
+    std::vector<Mask> mills;                       // Every mill as a mask
+    std::array<std::array<Mask, kMaxMillsPerPoint>, kMaxPoints> millsAt{}; // Mills through each point
+    std::array<int, kMaxPoints> millCountAt{};
+    int men = 3;
+    int minMen = 3;
+    int flyAt = 0;
+    CaptureRule capture = CaptureRule::Win;
+};
+
+using Rules32 = Rules<uint32_t>;
+using Rules64 = Rules<uint64_t>;
+
+// Compiles a board description into bitmask tables; fails if the board does not fit in Mask
+template <typename Mask>
+bool compileTopology(const Topology& topo, Rules<Mask>& rules, std::string& error) {
+    constexpr int kMaxPoints = Rules<Mask>::kMaxPoints;
+    const int n = static_cast<int>(topo.points.size());
+    if (n > kMaxPoints) {
+        error = "board has " + std::to_string(n) + " points, more than a " +
+                std::to_string(kMaxPoints) + "-bit board can hold";
+        return false;
+    }
+    if (topo.men * 2 > n) {
+        error = "board cannot hold " + std::to_string(topo.men) + " tokens per player";
+        return false;
+    }
+
+    rules = Rules<Mask>();
+    rules.points = n;
+    rules.full = n == kMaxPoints ? ~Mask(0) : ((Mask(1) << n) - 1);
+    rules.men = topo.men;
+    rules.minMen = topo.capture == CaptureRule::Remove ? topo.minMen : 0;
+    rules.flyAt = topo.flyAt;
+    rules.capture = topo.capture;
+
+    for (const auto& e : topo.edges) {
+        if (e[0] < 0 || e[0] >= n || e[1] < 0 || e[1] >= n || e[0] == e[1]) {
+            error = "edge " + std::to_string(e[0]) + "-" + std::to_string(e[1]) + " is out of range";
+            return false;
+        }
+        rules.adjacent[e[0]] |= Mask(1) << e[1];
+        rules.adjacent[e[1]] |= Mask(1) << e[0];
+    }
+
+    for (const auto& mill : topo.mills) {
+        Mask m = 0;
+        for (int p : mill) {
+            if (p < 0 || p >= n) {
+                error = "mill point " + std::to_string(p) + " is out of range";
+                return false;
+            }
+            m |= Mask(1) << p;
+        }
+        rules.mills.push_back(m);
+        for (int p : mill) {
+            if (rules.millCountAt[p] == kMaxMillsPerPoint) {
+                error = "point " + std::to_string(p) + " lies on too many mills";
+                return false;
+            }
+            rules.millsAt[p][rules.millCountAt[p]++] = m;
+        }
+    }
+    return true;
+}
+
+// A game position: tokens on the board, tokens still in hand and the player to move
+template <typename Mask>
+struct Position {
+    std::array<Mask, 2> men{};   // Occupied points per player, indexed by Player
+    std::array<int, 2> hand{};   // Tokens each player has yet to place
+    Player turn = Player::A;
+};
+
+using Position32 = Position<uint32_t>;
+using Position64 = Position<uint64_t>;
+
+// A move: place (from == -1) or slide/fly from -> to, optionally removing an opponent token
+struct Move {
+    int8_t from = -1;
+    int8_t to = -1;
+    int8_t remove = -1;
+};
+
+inline bool operator==(const Move& a, const Move& b) {
+    return a.from == b.from && a.to == b.to && a.remove == b.remove;
+}
+
+// Readable form of a move: "4" places on point 4, "3-4" slides or flies from 3 to 4,
+// and "x7" after either removes the opponent token on 7
+inline std::string moveName(const Move& m) {
+    if (m.to < 0) return "none";
+    std::string s = m.from >= 0 ? std::to_string(m.from) + "-" + std::to_string(m.to) : std::to_string(m.to);
+    if (m.remove >= 0) s += "x" + std::to_string(m.remove);
+    return s;
+}
+
+// Reads a move written by moveName(); false if 's' is not one
+inline bool parseMove(const std::string& s, Move& m) {
+    m = Move();
+    if (s == "none") return true;
+    std::size_t at = 0;
+    auto number = [&](int8_t& out) {
+        std::size_t start = at;
+        int v = 0;
+        for (; at < s.size() && s[at] >= '0' && s[at] <= '9' && at - start < 3; ++at) v = v * 10 + (s[at] - '0');
+        out = static_cast<int8_t>(v);
+        return at > start && v < 100;
+    };
+    if (!number(m.to)) return false;
+    if (at < s.size() && s[at] == '-') {
+        m.from = m.to;
+        ++at;
+        if (!number(m.to)) return false;
+    }
+    if (at < s.size() && s[at] == 'x') {
+        ++at;
+        if (!number(m.remove)) return false;
+    }
+    return at == s.size();
+}
+
+// Population count of a board mask
+template <typename Mask>
+inline int countMen(Mask m) {
+    return __builtin_popcountll(static_cast<unsigned long long>(m));
+}
+
+// Index of the lowest set point of a non-empty mask
+template <typename Mask>
+inline int lowestPoint(Mask m) {
+    return __builtin_ctzll(static_cast<unsigned long long>(m));
+}
+
+// Starting position: empty board, every token in hand, Player A to move
+template <typename Mask>
+Position<Mask> startPosition(const Rules<Mask>& rules) {
+    Position<Mask> pos;
+    pos.hand = {rules.men, rules.men};
+    return pos;
+}
+
+// True if the tokens in 'men' complete a mill through 'point'
+template <typename Mask>
+inline bool formsMill(const Rules<Mask>& rules, Mask men, int point) {
+    for (int i = 0; i < rules.millCountAt[point]; ++i) {
+        Mask m = rules.millsAt[point][i];
+        if ((men & m) == m) return true;
+    }
+    return false;
+}
+
+// True if 'men' contains any complete mill
+template <typename Mask>
+inline bool hasMill(const Rules<Mask>& rules, Mask men) {
+    for (Mask m : rules.mills)
+        if ((men & m) == m) return true;
+    return false;
+}
+
+// Tokens of 'men' that are part of a complete mill
+template <typename Mask>
+inline Mask menInMills(const Rules<Mask>& rules, Mask men) {
+    Mask inMill = 0;
+    for (Mask m : rules.mills)
+        if ((men & m) == m) inMill |= m;
+    return inMill;
+}
+
+// Opponent tokens that may be removed: those outside mills, or any if all are in mills
+template <typename Mask>
+inline Mask removableMen(const Rules<Mask>& rules, Mask men) {
+    Mask loose = men & ~menInMills(rules, men);
+    return loose ? loose : men;
+}
+
+// True if the player to move may fly to any empty point
+template <typename Mask>
+inline bool canFly(const Rules<Mask>& rules, const Position<Mask>& pos) {
+    int me = static_cast<int>(pos.turn);
+    return rules.flyAt > 0 && pos.hand[me] == 0 && countMen(pos.men[me]) == rules.flyAt;
+}
+
+// Empty points the token on 'from' may move to
+template <typename Mask>
+inline Mask destinations(const Rules<Mask>& rules, const Position<Mask>& pos, int from) {
+    Mask empty = rules.full & ~(pos.men[0] | pos.men[1]);
+    return canFly(rules, pos) ? empty : (rules.adjacent[from] & empty);
+}
+
+// True if the side to move has already lost before moving: the opponent closed a mill
+// under CaptureRule::Win, or the side to move is below the minimum token count
+template <typename Mask>
+inline bool isLost(const Rules<Mask>& rules, const Position<Mask>& pos) {
+    int me = static_cast<int>(pos.turn);
+    if (rules.capture == CaptureRule::Win)
+        return hasMill(rules, pos.men[1 - me]);
+    return countMen(pos.men[me]) + pos.hand[me] < rules.minMen;
+}
+
+// True if the game ended before the position arose, so no game reaches it: the side to
+// move holds a mill under CaptureRule::Win, or the opponent is below the minimum token count
+template <typename Mask>
+inline bool isPastGameEnd(const Rules<Mask>& rules, const Position<Mask>& pos) {
+    int me = static_cast<int>(pos.turn);
+    if (rules.capture == CaptureRule::Win && hasMill(rules, pos.men[me])) return true;
+    return countMen(pos.men[1 - me]) + pos.hand[1 - me] < rules.minMen;
+}
+
+// Appends a move to 'out', expanding it into one move per legal removal when it closes a mill
+template <typename Mask>
+inline int emitMove(const Rules<Mask>& rules, const Position<Mask>& pos, Mask mine, int from, int to, Move* out, int n) {
+    if (rules.capture == CaptureRule::Remove && formsMill(rules, mine, to)) {
+        Mask theirs = pos.men[1 - static_cast<int>(pos.turn)];
+        for (Mask r = removableMen(rules, theirs); r; r &= r - 1)
+            out[n++] = Move{static_cast<int8_t>(from), static_cast<int8_t>(to), static_cast<int8_t>(lowestPoint(r))};
+    } else {
+        out[n++] = Move{static_cast<int8_t>(from), static_cast<int8_t>(to), -1};
+    }
+    return n;
+}
+
+// Generates every legal move for the side to move into 'out' (capacity kMaxMoves).
+// Returns the number of moves; zero means the side to move is blocked.
+template <typename Mask>
+int generateMoves(const Rules<Mask>& rules, const Position<Mask>& pos, Move* out) {
+    int me = static_cast<int>(pos.turn);
+    Mask mine = pos.men[me];
+    Mask empty = rules.full & ~(pos.men[0] | pos.men[1]);
+    int n = 0;
+    if (pos.hand[me] > 0) {
+        for (Mask e = empty; e; e &= e - 1) {
+            int to = lowestPoint(e);
+            n = emitMove(rules, pos, Mask(mine | (Mask(1) << to)), -1, to, out, n);
+        }
+        return n;
+    }
+    bool fly = canFly(rules, pos);
+    for (Mask m = mine; m; m &= m - 1) {
+        int from = lowestPoint(m);
+        Mask targets = fly ? empty : (rules.adjacent[from] & empty);
+        for (; targets; targets &= targets - 1) {
+            int to = lowestPoint(targets);
+            Mask after = (mine & ~(Mask(1) << from)) | (Mask(1) << to);
+            n = emitMove(rules, pos, after, from, to, out, n);
+        }
+    }
+    return n;
+}
+
+// Returns the position after 'move' has been played
+template <typename Mask>
+Position<Mask> applyMove(const Position<Mask>& pos, const Move& move) {
+    Position<Mask> next = pos;
+    int me = static_cast<int>(pos.turn);
+    if (move.from < 0) next.hand[me]--;
+    else next.men[me] &= ~(Mask(1) << move.from);
+    next.men[me] |= Mask(1) << move.to;
+    if (move.remove >= 0) next.men[1 - me] &= ~(Mask(1) << move.remove);
+    next.turn = opponent(pos.turn);
+    return next;
+}
+
+// Zobrist keys: a random 64-bit key per player and point, per player and tokens in hand,
+// and one for Player B to move. A position hashes to the XOR of the keys of its features,
+// so a move updates the hash with a few XORs (updateHash) rather than a full rehash.
+template <typename Mask>
+struct ZobristKeys {
+    static constexpr int kMaxPoints = Rules<Mask>::kMaxPoints;
+
+    std::array<std::array<uint64_t, kMaxPoints>, 2> point{};
+    std::array<std::array<uint64_t, kMaxPoints + 1>, 2> hand{};
+    uint64_t playerB = 0;
+
+    explicit ZobristKeys(uint64_t seed = 0x5A0B1257C0FFEEull) {
+        auto next = [&seed] { // splitmix64
+            uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        };
+        for (auto& keys : point)
+            for (auto& k : keys) k = next();
+        for (auto& keys : hand)
+            for (auto& k : keys) k = next();
+        playerB = next();
+    }
+};
+
+// Hash of a position, from scratch
+template <typename Mask>
+uint64_t hashPosition(const ZobristKeys<Mask>& keys, const Position<Mask>& pos) {
+    uint64_t h = pos.turn == Player::B ? keys.playerB : 0;
+    for (int p = 0; p < 2; ++p) {
+        h ^= keys.hand[p][pos.hand[p]];
+        for (Mask m = pos.men[p]; m; m &= m - 1) h ^= keys.point[p][lowestPoint(m)];
+    }
+    return h;
+}
+
+// Hash of applyMove(pos, move), given the hash of pos
+template <typename Mask>
+uint64_t updateHash(const ZobristKeys<Mask>& keys, uint64_t h, const Position<Mask>& pos, const Move& move) {
+    int me = static_cast<int>(pos.turn);
+    if (move.from < 0) h ^= keys.hand[me][pos.hand[me]] ^ keys.hand[me][pos.hand[me] - 1];
+    else h ^= keys.point[me][move.from];
+    h ^= keys.point[me][move.to];
+    if (move.remove >= 0) h ^= keys.point[1 - me][move.remove];
+    return h ^ keys.playerB;
+}
+
+// True if the game is over and the side to move has lost (beaten or blocked)
+template <typename Mask>
+bool isGameOver(const Rules<Mask>& rules, const Position<Mask>& pos) {
+    if (isLost(rules, pos)) return true;
+    Move moves[kMaxMoves];
+    return generateMoves(rules, pos, moves) == 0;
+}
+
+// Text picture of a position: points are laid out on the grid of their distinct x and y
+// coordinates and shown as 'A', 'B' or '.', with the token counts and the side to move below
+template <typename Mask>
+std::string boardDiagram(const Topology& topo, const Position<Mask>& pos) {
+    std::vector<float> xs, ys;
+    for (const auto& p : topo.points) {
+        xs.push_back(p.x);
+        ys.push_back(p.y);
+    }
+    for (auto* v : {&xs, &ys}) {
+        std::sort(v->begin(), v->end());
+        v->erase(std::unique(v->begin(), v->end()), v->end());
+    }
+    std::vector<std::string> rows(ys.size(), std::string(xs.size() * 2 - 1, ' '));
+    for (std::size_t i = 0; i < topo.points.size(); ++i) {
+        std::size_t col = std::lower_bound(xs.begin(), xs.end(), topo.points[i].x) - xs.begin();
+        std::size_t row = std::lower_bound(ys.begin(), ys.end(), topo.points[i].y) - ys.begin();
+        Mask bit = Mask(1) << i;
+        rows[row][col * 2] = (pos.men[0] & bit) ? 'A' : (pos.men[1] & bit) ? 'B' : '.';
+    }
+    std::string out;
+    for (const auto& r : rows) out += "  " + r + "\n";
+    out += "  A: " + std::to_string(countMen(pos.men[0])) + " on board, " + std::to_string(pos.hand[0]) + " in hand\n";
+    out += "  B: " + std::to_string(countMen(pos.men[1])) + " on board, " + std::to_string(pos.hand[1]) + " in hand\n";
+    out += std::string("  ") + (pos.turn == Player::A ? "A" : "B") + " to move\n";
+    return out;
+}
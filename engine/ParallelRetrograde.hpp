@@ -0,0 +1,338 @@
+/*
+Parallel retrograde - in-memory backward propagation for movement groups
+
+RetrogradeSolver decides a cyclic group layer by layer, re-reading the
+children of every undecided position on every layer. When a group fits in
+RAM, going backwards is far cheaper: every position is expanded once to
+count its children, and from then on only the positions decided on the
+last layer are touched, by generating their predecessors (un-moves).
+
+  - A position is lost once its last child has turned out to be a win, so
+    each position keeps an atomic count of its undecided children.
+  - A position is won the first time one of its children is lost.
+  - Children outside the group (captures into smaller partitions) are
+    already solved and are read once, up front.
+
+The frontier of each layer is cut into batches held in per-thread deques;
+a thread works through its own deque from the back and steals from the
+front of the others when it runs dry. Positions are claimed through a
+bit-packed decided map, so exactly one thread writes each value. Layers are
+still processed in order, which gives the same distances as the layered
+solver, byte for byte.
+*/
+
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include "Retrograde.hpp"
+
+// Batches of positions; the owner pushes and pops at the back, thieves take from the front
+class StealingDeque {
+public:
+    void push(std::vector<uint64_t>&& batch) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        batches_.push_back(std::move(batch));
+    }
+
+    bool pop(std::vector<uint64_t>& batch) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (batches_.empty()) return false;
+        batch = std::move(batches_.back());
+        batches_.pop_back();
+        return true;
+    }
+
+    bool steal(std::vector<uint64_t>& batch) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (batches_.empty()) return false;
+        batch = std::move(batches_.front());
+        batches_.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<std::vector<uint64_t>> batches_;
+};
+
+// Positions of a cyclic group (one movement partition or a mirrored pair) under a
+// single global index, the partitions laid out one after the other
+template <typename Mask>
+class GroupLayout {
+public:
+    GroupLayout(const Rules<Mask>& rules, const PositionIndexer<Mask>& indexer, TableStore<Mask>& store)
+        : rules_(rules), indexer_(indexer), store_(store) {}
+
+    // What the children outside the group (captures) say about a position
+    struct Exits {
+        uint8_t minLoss = kUnknown; // Shortest loss, kUnknown if none
+        uint8_t maxWin = 0;         // Longest win
+        bool draw = false;
+    };
+
+    void assign(const std::vector<PartitionKey>& group, const std::vector<uint8_t*>& values) {
+        keys_ = group;
+        values_ = values;
+        offsets_.assign(1, 0);
+        for (const auto& key : group) offsets_.push_back(offsets_.back() + indexer_.size(key));
+    }
+
+    uint64_t size() const { return offsets_.back(); }
+
+    int partOf(uint64_t g) const { return g >= offsets_[1] ? 1 : 0; }
+    uint8_t value(uint64_t g) const { return values_[partOf(g)][g - offsets_[partOf(g)]]; }
+    void setValue(uint64_t g, uint8_t v) { values_[partOf(g)][g - offsets_[partOf(g)]] = v; }
+
+    Position<Mask> positionOf(uint64_t g) const {
+        int part = partOf(g);
+        return partitionPosition(indexer_, keys_[part], g - offsets_[part]);
+    }
+
+    // Global index of a position of the group with Player A to move
+    uint64_t globalIndex(Mask stm, Mask opp) const {
+        PartitionKey key{countMen(stm), 0, countMen(opp), 0};
+        int part = key == keys_[0] ? 0 : 1;
+        return offsets_[part] + indexer_.index(key, stm, opp);
+    }
+
+    // Slots that index() never produces hold a copy of their canonical twin
+    uint64_t canonicalIndex(uint64_t g) const {
+        Position<Mask> pos = positionOf(g);
+        return globalIndex(pos.men[0], pos.men[1]);
+    }
+
+    // Writes the global indices of the children of 'pos' inside the group to 'inside'
+    // (repeats included) and summarises the children outside it. Returns the count.
+    int expand(const Position<Mask>& pos, const Move* moves, int n, uint64_t* inside, Exits& exits) const {
+        int count = 0;
+        PartitionKey captureKey{};
+        const uint8_t* captureValues = nullptr;
+        for (int i = 0; i < n; ++i) {
+            Position<Mask> child = applyMove(pos, moves[i]);
+            if (moves[i].remove < 0) {
+                inside[count++] = globalIndex(child.men[1], child.men[0]);
+                continue;
+            }
+            if (!captureValues) {
+                captureKey = partitionOf(child);
+                captureValues = isStored(rules_, captureKey) ? store_.values(captureKey) : nullptr;
+            }
+            uint8_t v = captureValues ? captureValues[indexer_.index(captureKey, child.men[1], child.men[0])] : 0;
+            if (isLossValue(v)) exits.minLoss = std::min(exits.minLoss, v);
+            else if (isWinValue(v)) exits.maxWin = std::max(exits.maxWin, v);
+            else exits.draw = true;
+        }
+        return count;
+    }
+
+private:
+    const Rules<Mask>& rules_;
+    const PositionIndexer<Mask>& indexer_;
+    TableStore<Mask>& store_;
+    std::vector<PartitionKey> keys_;
+    std::vector<uint8_t*> values_;
+    std::vector<uint64_t> offsets_;
+};
+
+// Solves cyclic (movement) groups in memory. Plug it into RetrogradeSolver with
+// setCyclicSolver(); partitions the group captures into must be in 'store'.
+template <typename Mask>
+class ParallelRetrograde {
+public:
+    ParallelRetrograde(const Rules<Mask>& rules, const PositionIndexer<Mask>& indexer, TableStore<Mask>& store, int threads)
+        : rules_(rules), layout_(rules, indexer, store), threads_(std::max(1, threads)) {}
+
+    // Fills values[i] for the partitions of 'group' (one or a mirrored pair)
+    bool solve(const std::vector<PartitionKey>& group, const std::vector<uint8_t*>& values, std::string& error) {
+        layout_.assign(group, values);
+        const uint64_t total = layout_.size();
+
+        decided_.reset(new std::atomic<uint64_t>[(total + 63) / 64]);
+        remaining_.reset(new std::atomic<uint8_t>[total]);
+        for (uint64_t w = 0; w < (total + 63) / 64; ++w) decided_[w].store(0, std::memory_order_relaxed);
+        pending_.assign(threads_, std::vector<std::vector<uint64_t>>(kMaxDistance + 2));
+        frontier_.reset(new StealingDeque[threads_]);
+        next_.reset(new StealingDeque[threads_]);
+
+        std::atomic<bool> failed{false};
+        std::atomic<uint64_t> nextChunk{0};
+        runWorkers(threads_, [&](int t) {
+            Batcher out(frontier_[t]);
+            const uint64_t chunk = 1 << 12;
+            for (uint64_t begin; (begin = nextChunk.fetch_add(chunk)) < total;)
+                for (uint64_t g = begin; g < std::min(total, begin + chunk); ++g)
+                    if (!initialize(g, t, out)) failed = true;
+        });
+        if (failed) {
+            error = "a position of " + group[0].name() + " has more than 255 distinct children";
+            return false;
+        }
+
+        // Layer d holds the positions decided at distance d; their predecessors are decided at d + 1
+        for (int d = 0;; ++d) {
+            if (d > kMaxDistance) {
+                error = "distances exceed " + std::to_string(kMaxDistance) + " plies";
+                return false;
+            }
+            for (int t = 0; t < threads_; ++t) {
+                Batcher out(frontier_[t]);
+                for (uint64_t g : pending_[t][d])
+                    if (claim(g)) layout_.setValue(g, static_cast<uint8_t>(d)), out.add(g);
+                std::vector<uint64_t>().swap(pending_[t][d]);
+            }
+            std::atomic<uint64_t> expanded{0};
+            runWorkers(threads_, [&](int t) {
+                Batcher out(next_[t]);
+                std::vector<uint64_t> batch;
+                uint64_t count = 0;
+                for (;;) {
+                    bool found = frontier_[t].pop(batch);
+                    for (int i = 1; i < threads_ && !found; ++i) found = frontier_[(t + i) % threads_].steal(batch);
+                    if (!found) break;
+                    for (uint64_t g : batch) propagate(g, d, t, out);
+                    count += batch.size();
+                }
+                expanded += count;
+            });
+            std::swap(frontier_, next_);
+            bool more = false;
+            for (int t = 0; t < threads_; ++t)
+                for (int later = d + 1; later <= kMaxDistance + 1 && !more; ++later) more = !pending_[t][later].empty();
+            if (expanded == 0 && !more) break;
+        }
+
+        // Never decided: draws. Slots that index() never produces copy their canonical twin.
+        parallelFor(total, threads_, [&](uint64_t begin, uint64_t end) {
+            for (uint64_t g = begin; g < end; ++g) {
+                if (isDecided(g)) continue;
+                layout_.setValue(g, kDraw);
+            }
+        });
+        parallelFor(total, threads_, [&](uint64_t begin, uint64_t end) {
+            for (uint64_t g = begin; g < end; ++g) {
+                uint64_t canonical = layout_.canonicalIndex(g);
+                if (canonical != g) layout_.setValue(g, layout_.value(canonical));
+            }
+        });
+        decided_.reset();
+        remaining_.reset();
+        pending_.clear();
+        return true;
+    }
+
+private:
+    static constexpr std::size_t kBatch = 1024;
+
+    // Collects positions into batches for a deque
+    struct Batcher {
+        explicit Batcher(StealingDeque& target) : deque(target) {}
+        ~Batcher() {
+            if (!batch.empty()) deque.push(std::move(batch));
+        }
+        void add(uint64_t g) {
+            batch.push_back(g);
+            if (batch.size() == kBatch) {
+                deque.push(std::move(batch));
+                batch.clear();
+            }
+        }
+        StealingDeque& deque;
+        std::vector<uint64_t> batch;
+    };
+
+    bool isDecided(uint64_t g) const {
+        return (decided_[g >> 6].load(std::memory_order_relaxed) >> (g & 63)) & 1;
+    }
+
+    // True for the one thread that marks g decided
+    bool claim(uint64_t g) {
+        uint64_t bit = uint64_t(1) << (g & 63);
+        return !(decided_[g >> 6].fetch_or(bit, std::memory_order_relaxed) & bit);
+    }
+
+    // Counts the children inside the group, reads the ones outside it, and
+    // schedules the positions whose value the outside children already fix.
+    // While a position is undecided its value byte holds the longest win among
+    // its outside children, kDraw if one of them is a draw, or kUnknown if one
+    // of them is lost (the position is a win and can never be lost).
+    bool initialize(uint64_t g, int t, Batcher& out) {
+        remaining_[g].store(0, std::memory_order_relaxed);
+        if (layout_.canonicalIndex(g) != g) { // Filled in from the twin at the end
+            claim(g);
+            return true;
+        }
+        Position<Mask> pos = layout_.positionOf(g);
+        Move moves[kMaxMoves];
+        int n = isLost(rules_, pos) ? 0 : generateMoves(rules_, pos, moves);
+        if (n == 0) {
+            claim(g);
+            layout_.setValue(g, 0);
+            out.add(g);
+            return true;
+        }
+
+        uint64_t inside[kMaxMoves];
+        typename GroupLayout<Mask>::Exits exits;
+        int count = layout_.expand(pos, moves, n, inside, exits);
+        std::sort(inside, inside + count);
+        count = static_cast<int>(std::unique(inside, inside + count) - inside);
+        if (count > 255) return false;
+
+        remaining_[g].store(static_cast<uint8_t>(count), std::memory_order_relaxed);
+        layout_.setValue(g, exits.minLoss != kUnknown ? kUnknown : exits.draw ? kDraw : exits.maxWin);
+        if (exits.minLoss != kUnknown) pending_[t][exits.minLoss + 1].push_back(g);
+        else if (count == 0 && !exits.draw) pending_[t][exits.maxWin + 1].push_back(g);
+        return true;
+    }
+
+    // Passes the value of g (decided at distance d) on to its predecessors
+    void propagate(uint64_t g, int d, int t, Batcher& out) {
+        uint64_t parents[kMaxMoves];
+        int n = predecessors(layout_.positionOf(g), parents);
+        std::sort(parents, parents + n);
+        n = static_cast<int>(std::unique(parents, parents + n) - parents);
+        for (int i = 0; i < n; ++i) {
+            uint64_t p = parents[i];
+            if (isDecided(p)) continue;
+            if (!(d & 1)) { // g is lost: p wins by moving there
+                if (claim(p)) layout_.setValue(p, static_cast<uint8_t>(d + 1)), out.add(p);
+                continue;
+            }
+            if (remaining_[p].fetch_sub(1, std::memory_order_relaxed) != 1) continue;
+            uint8_t exitWin = layout_.value(p); // Only this thread reads it: no wins are claimed on odd layers
+            if (exitWin == kDraw || exitWin == kUnknown) continue;
+            int loss = std::max(d, static_cast<int>(exitWin)) + 1;
+            if (loss != d + 1) pending_[t][std::min(loss, kMaxDistance + 1)].push_back(p);
+            else if (claim(p)) layout_.setValue(p, static_cast<uint8_t>(loss)), out.add(p);
+        }
+    }
+
+    // Positions of the group with a non-capturing slide to 'child' (Player A to move
+    // in the child, so Player B made the slide)
+    int predecessors(const Position<Mask>& child, uint64_t* out) const {
+        Mask waiting = child.men[0], mover = child.men[1];
+        Mask empty = rules_.full & ~(waiting | mover);
+        bool fly = rules_.flyAt > 0 && countMen(mover) == rules_.flyAt;
+        int n = 0;
+        for (Mask m = mover; m; m &= m - 1) {
+            int to = lowestPoint(m);
+            if (rules_.capture == CaptureRule::Remove && formsMill(rules_, mover, to)) continue; // Would have captured
+            for (Mask f = fly ? empty : (rules_.adjacent[to] & empty); f; f &= f - 1) {
+                Mask before = (mover & ~(Mask(1) << to)) | (f & (~f + 1));
+                out[n++] = layout_.globalIndex(before, waiting);
+            }
+        }
+        return n;
+    }
+
+    const Rules<Mask>& rules_;
+    GroupLayout<Mask> layout_;
+    int threads_;
+
+    std::unique_ptr<std::atomic<uint64_t>[]> decided_; // One bit per position
+    std::unique_ptr<std::atomic<uint8_t>[]> remaining_; // Undecided children inside the group
+    std::vector<std::vector<std::vector<uint64_t>>> pending_; // [thread][distance]: decided by outside children
+    std::unique_ptr<StealingDeque[]> frontier_, next_;
+};
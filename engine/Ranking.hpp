@@ -0,0 +1,384 @@
+/*
+Ranking - dense position indices for the solver and the tablebases
+
+Positions of a partition (fixed piece counts, see Retrograde.hpp) are indexed
+with the combinatorial number system instead of a 3^n encoding: the side to
+move's tokens are ranked among all C(points, stmMen) subsets and the
+opponent's among the C(points - stmMen, oppMen) subsets of the free points,
+which is a bijection onto [0, C * C').
+
+CombinationRanker ranks and unranks a subset one byte at a time with
+prefix-count tables, so a rank is one table lookup per byte of the board and
+an unrank is an 8-step branchless search per byte.
+
+PositionIndexer adds the symmetries of the board (found from its edges and
+mills): the side to move's tokens are mapped to the smallest equivalent
+subset and only those canonical subsets get an index, which shrinks every
+partition by up to the size of the symmetry group (8 for the 3x3 board, 16
+for the square Morris boards).
+*/
+
+#pragma once
+
+#include <array>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include "Morris.hpp"
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+// Piece counts that identify a partition, from the side to move's point of view
+struct PartitionKey {
+    int stmMen = 0;
+    int stmHand = 0;
+    int oppMen = 0;
+    int oppHand = 0;
+
+    std::string name() const {
+        return std::to_string(stmMen) + "_" + std::to_string(stmHand) + "_" +
+               std::to_string(oppMen) + "_" + std::to_string(oppHand);
+    }
+};
+
+inline bool operator<(const PartitionKey& a, const PartitionKey& b) {
+    return std::tie(a.stmMen, a.stmHand, a.oppMen, a.oppHand) < std::tie(b.stmMen, b.stmHand, b.oppMen, b.oppHand);
+}
+
+inline bool operator==(const PartitionKey& a, const PartitionKey& b) {
+    return !(a < b) && !(b < a);
+}
+
+template <typename Mask>
+inline PartitionKey partitionOf(const Position<Mask>& pos) {
+    int me = static_cast<int>(pos.turn);
+    return PartitionKey{countMen(pos.men[me]), pos.hand[me], countMen(pos.men[1 - me]), pos.hand[1 - me]};
+}
+
+// Binomial coefficients C(n, k) for n, k <= 64
+inline uint64_t binomial(int n, int k) {
+    static const auto table = [] {
+        std::array<std::array<uint64_t, 65>, 65> c{};
+        for (int i = 0; i <= 64; ++i) {
+            c[i][0] = 1;
+            for (int j = 1; j <= i; ++j)
+                c[i][j] = c[i - 1][j - 1] + (j < i ? c[i - 1][j] : 0);
+        }
+        return c;
+    }();
+    return (k < 0 || k > n) ? 0 : table[n][k];
+}
+
+// Colex rank of a mask among all masks with the same number of bits (bit by bit)
+template <typename Mask>
+inline uint64_t rankMask(Mask m) {
+    uint64_t r = 0;
+    for (int j = 1; m; m &= m - 1, ++j)
+        r += binomial(lowestPoint(m), j);
+    return r;
+}
+
+// Inverse of rankMask for masks with k bits (bit by bit)
+template <typename Mask>
+inline Mask unrankMask(uint64_t r, int k) {
+    Mask m = 0;
+    int i = std::numeric_limits<Mask>::digits - 1;
+    for (int j = k; j > 0; --j) {
+        while (binomial(i, j) > r) --i;
+        r -= binomial(i, j);
+        m |= Mask(1) << i;
+        --i;
+    }
+    return m;
+}
+
+// Per-byte popcount, bit extract and bit deposit, so the helpers below need neither
+// a popcount instruction nor BMI2
+struct ByteTables {
+    uint8_t popcount[256];
+    uint8_t extract[256][256]; // [within][bits]: bits at the set positions of 'within', packed
+    uint8_t deposit[256][256]; // [within][bits]: low bits spread over the set positions of 'within'
+};
+
+inline const ByteTables& byteTables() {
+    static const ByteTables tables = [] {
+        ByteTables t{};
+        for (int w = 0; w < 256; ++w) {
+            t.popcount[w] = static_cast<uint8_t>(__builtin_popcount(w));
+            for (int b = 0; b < 256; ++b) {
+                int packed = 0, spread = 0, i = 0;
+                for (int bit = 0; bit < 8; ++bit) {
+                    if (!((w >> bit) & 1)) continue;
+                    if ((b >> bit) & 1) packed |= 1 << i;
+                    if ((b >> i) & 1) spread |= 1 << bit;
+                    ++i;
+                }
+                t.extract[w][b] = static_cast<uint8_t>(packed);
+                t.deposit[w][b] = static_cast<uint8_t>(spread);
+            }
+        }
+        return t;
+    }();
+    return tables;
+}
+
+// Packs the bits of 'm' found at the set positions of 'within' into the low bits
+template <typename Mask>
+inline Mask compressMask(Mask m, Mask within) {
+#ifdef __BMI2__
+    return static_cast<Mask>(_pext_u64(m, within));
+#else
+    const ByteTables& t = byteTables();
+    Mask r = 0;
+    int shift = 0;
+    for (int level = 0; level < std::numeric_limits<Mask>::digits / 8; ++level) {
+        unsigned w = static_cast<unsigned>(within >> (8 * level)) & 0xFF;
+        r |= Mask(t.extract[w][(m >> (8 * level)) & 0xFF]) << shift;
+        shift += t.popcount[w];
+    }
+    return r;
+#endif
+}
+
+// Inverse of compressMask
+template <typename Mask>
+inline Mask expandMask(Mask bits, Mask within) {
+#ifdef __BMI2__
+    return static_cast<Mask>(_pdep_u64(bits, within));
+#else
+    const ByteTables& t = byteTables();
+    Mask r = 0;
+    for (int level = 0; level < std::numeric_limits<Mask>::digits / 8; ++level) {
+        unsigned w = static_cast<unsigned>(within >> (8 * level)) & 0xFF;
+        r |= Mask(t.deposit[w][bits & 0xFF]) << (8 * level);
+        bits >>= t.popcount[w];
+    }
+    return r;
+#endif
+}
+
+// Colex rank and unrank of subsets of the low 'bits' bits, a byte at a time.
+// prefix[level][k][u] counts the k-subsets of bits below (level + 1) * 8 whose byte
+// 'level' is smaller than u and whose higher bytes are zero.
+template <typename Mask>
+class CombinationRanker {
+public:
+    explicit CombinationRanker(int bits) : bits_(bits), levels_((bits + 7) / 8) {
+        prefix_.assign(std::size_t(levels_) * (bits_ + 1) * 257, 0);
+        for (int level = 0; level < levels_; ++level)
+            for (int k = 0; k <= bits_; ++k) {
+                uint64_t* p = &prefix_[(std::size_t(level) * (bits_ + 1) + k) * 257];
+                for (int u = 0; u < 256; ++u)
+                    p[u + 1] = p[u] + binomial(8 * level, k - __builtin_popcount(u));
+            }
+    }
+
+    // Colex rank of 'm'. The bits up to each byte decide that byte's term, so the
+    // bytes are read from the bottom with a running count.
+    uint64_t rank(Mask m) const {
+        const ByteTables& t = byteTables();
+        uint64_t r = 0;
+        int k = 0;
+        for (int level = 0; level < levels_; ++level) {
+            unsigned u = static_cast<unsigned>(m >> (8 * level)) & 0xFF;
+            k += t.popcount[u];
+            r += row(level, k)[u];
+        }
+        return r;
+    }
+
+    // The k-bit mask with colex rank r
+    Mask unrank(uint64_t r, int k) const {
+        const ByteTables& t = byteTables();
+        Mask m = 0;
+        for (int level = levels_ - 1; level >= 0; --level) {
+            const uint64_t* p = row(level, k);
+            unsigned u = 0;
+            for (unsigned step = 128; step; step >>= 1) // Largest u with p[u] <= r
+                u += (p[u + step] <= r) ? step : 0;
+            r -= p[u];
+            k -= t.popcount[u];
+            m |= Mask(u) << (8 * level);
+        }
+        return m;
+    }
+
+private:
+    const uint64_t* row(int level, int k) const {
+        return &prefix_[(std::size_t(level) * (bits_ + 1) + k) * 257];
+    }
+
+    int bits_;
+    int levels_;
+    std::vector<uint64_t> prefix_;
+};
+
+// Point permutations that map the board's edges onto edges and mills onto mills.
+// The identity comes first.
+template <typename Mask>
+std::vector<std::vector<int>> findSymmetries(const Rules<Mask>& rules) {
+    const int n = rules.points;
+    std::vector<std::vector<int>> found;
+    std::vector<int> perm(n, -1);
+    std::vector<bool> used(n, false);
+    auto degree = [&](int p) { return countMen(rules.adjacent[p]); };
+    auto linked = [&](int a, int b) { return (rules.adjacent[a] >> b) & 1; };
+
+    std::function<void(int)> extend = [&](int i) {
+        if (i == n) {
+            for (Mask mill : rules.mills) {
+                Mask image = 0;
+                for (Mask m = mill; m; m &= m - 1) image |= Mask(1) << perm[lowestPoint(m)];
+                if (std::find(rules.mills.begin(), rules.mills.end(), image) == rules.mills.end()) return;
+            }
+            found.push_back(perm);
+            return;
+        }
+        for (int j = 0; j < n; ++j) {
+            if (used[j] || degree(j) != degree(i) || rules.millCountAt[j] != rules.millCountAt[i]) continue;
+            bool ok = true;
+            for (int k = 0; k < i && ok; ++k)
+                ok = linked(i, k) == linked(j, perm[k]);
+            if (!ok) continue;
+            perm[i] = j;
+            used[j] = true;
+            extend(i + 1);
+            used[j] = false;
+        }
+        perm[i] = -1;
+    };
+    extend(0);
+    // Backtracking tries the identity image of every point first, so it is found first
+    return found;
+}
+
+// Dense, symmetry-reduced indices of the positions in each partition
+template <typename Mask>
+class PositionIndexer {
+public:
+    static constexpr int kMaxSymmetries = 32;
+
+    PositionIndexer(const Rules<Mask>& rules, bool useSymmetry = true)
+        : points_(rules.points), levels_((rules.points + 7) / 8), full_(rules.full), ranker_(rules.points) {
+        std::vector<std::vector<int>> perms = useSymmetry ? findSymmetries(rules) : std::vector<std::vector<int>>();
+        if (perms.size() <= 1 || perms.size() > kMaxSymmetries) return; // Plain combinatorial indices
+        symmetries_ = static_cast<int>(perms.size());
+
+        // Byte-wise permutation tables: a transform is one lookup per byte of the mask
+        transform_.assign(std::size_t(symmetries_) * levels_ * 256, 0);
+        for (int s = 0; s < symmetries_; ++s)
+            for (int level = 0; level < levels_; ++level)
+                for (int u = 0; u < 256; ++u) {
+                    Mask image = 0;
+                    for (int b = 0; b < 8; ++b) {
+                        int p = level * 8 + b;
+                        if (((u >> b) & 1) && p < points_) image |= Mask(1) << perms[s][p];
+                    }
+                    transform_[(std::size_t(s) * levels_ + level) * 256 + u] = image;
+                }
+
+        // Canonical subsets for every token count a player can have on the board.
+        // The canonical subset of a class is its smallest mask, which is also the first
+        // one met in colex order, so classes are numbered in a single pass.
+        classes_.resize(std::min(rules.men, points_) + 1);
+        for (int k = 0; k < static_cast<int>(classes_.size()); ++k) {
+            ClassTable& table = classes_[k];
+            uint64_t subsets = binomial(points_, k);
+            table.entry.resize(subsets);
+            for (uint64_t r = 0; r < subsets; ++r) {
+                Mask m = ranker_.unrank(r, k);
+                Mask rep = m;
+                uint32_t toRep = 0;
+                for (int s = 1; s < symmetries_; ++s) {
+                    Mask image = transform(s, m);
+                    if (image < rep) rep = image, toRep = static_cast<uint32_t>(s);
+                }
+                if (rep == m) {
+                    uint32_t stabilizer = 0;
+                    for (int s = 0; s < symmetries_; ++s)
+                        if (transform(s, m) == m) stabilizer |= 1u << s;
+                    table.entry[r] = static_cast<uint32_t>(table.reps.size()) << kClassShift |
+                                     (stabilizer != 1u ? kSymmetricClass : 0);
+                    table.reps.push_back(m);
+                    table.stabilizer.push_back(stabilizer);
+                } else {
+                    table.entry[r] = (table.entry[ranker_.rank(rep)] & ~kSymmetryBits) | toRep;
+                }
+            }
+        }
+    }
+
+    int symmetries() const { return symmetries_; }
+    const CombinationRanker<Mask>& ranker() const { return ranker_; }
+
+    // Image of a mask under symmetry s
+    Mask transform(int s, Mask m) const {
+        if (symmetries_ == 1) return m;
+        const Mask* t = &transform_[std::size_t(s) * levels_ * 256];
+        Mask image = 0;
+        for (int level = 0; level < levels_; ++level, t += 256)
+            image |= t[(m >> (8 * level)) & 0xFF];
+        return image;
+    }
+
+    // Number of indices in a partition
+    uint64_t size(const PartitionKey& key) const {
+        uint64_t stmSubsets = symmetries_ == 1 ? binomial(points_, key.stmMen) : classes_[key.stmMen].reps.size();
+        return stmSubsets * binomial(points_ - key.stmMen, key.oppMen);
+    }
+
+    // Index of a position: the symmetry that maps the side to move's tokens to their
+    // canonical subset is applied to both sides. When that subset is itself
+    // symmetric, the image with the smallest opponent mask is chosen.
+    uint64_t index(const PartitionKey& key, Mask stm, Mask opp) const {
+        uint64_t oppSubsets = binomial(points_ - key.stmMen, key.oppMen);
+        if (symmetries_ == 1)
+            return ranker_.rank(stm) * oppSubsets + ranker_.rank(compressMask(opp, Mask(full_ & ~stm)));
+        const ClassTable& table = classes_[key.stmMen];
+        uint32_t entry = table.entry[ranker_.rank(stm)];
+        uint32_t cls = entry >> kClassShift;
+        int toRep = static_cast<int>(entry & kSymmetryBits);
+        Mask rep = transform(toRep, stm);
+        Mask oppImage = transform(toRep, opp);
+        if (entry & kSymmetricClass) {
+            Mask canonical = oppImage;
+            for (uint32_t rest = table.stabilizer[cls] & ~1u; rest; rest &= rest - 1)
+                canonical = std::min(canonical, transform(__builtin_ctz(rest), oppImage));
+            oppImage = canonical;
+        }
+        return cls * oppSubsets + ranker_.rank(compressMask(oppImage, Mask(full_ & ~rep)));
+    }
+
+    // A position with the given index (the canonical representative)
+    void position(const PartitionKey& key, uint64_t index, Mask& stm, Mask& opp) const {
+        uint64_t oppSubsets = binomial(points_ - key.stmMen, key.oppMen);
+        uint64_t cls = index / oppSubsets;
+        stm = symmetries_ == 1 ? ranker_.unrank(cls, key.stmMen) : classes_[key.stmMen].reps[cls];
+        opp = expandMask(ranker_.unrank(index % oppSubsets, key.oppMen), Mask(full_ & ~stm));
+    }
+
+private:
+    static constexpr uint32_t kSymmetryBits = 31;      // Symmetry mapping a subset to its class
+    static constexpr uint32_t kSymmetricClass = 1 << 5; // The canonical subset has a non-trivial stabilizer
+    static constexpr int kClassShift = 6;
+
+    // Canonical subsets of one size
+    struct ClassTable {
+        std::vector<uint32_t> entry;      // By colex rank: class, kSymmetricClass flag and symmetry
+        std::vector<Mask> reps;           // Canonical subset of each class
+        std::vector<uint32_t> stabilizer; // Symmetries that map the canonical subset to itself
+    };
+
+    int points_;
+    int levels_;
+    Mask full_;
+    int symmetries_ = 1;
+    CombinationRanker<Mask> ranker_;
+    std::vector<Mask> transform_;
+    std::vector<ClassTable> classes_;
+};
@@ -0,0 +1,590 @@
+/*
+Retrograde solver - perfect play tables for any Morris board
+
+The state space is split into partitions by piece counts: tokens on the board
+and in hand for the side to move and for the opponent. Positions are always
+stored from the point of view of the side to move and indexed up to the
+symmetries of the board (see Ranking.hpp), so a partition holds about
+C(points, stmMen) * C(points - stmMen, oppMen) / symmetries positions. Partitions are solved in dependency order:
+placement and captures only ever lead to partitions with fewer tokens in hand
+or on the board, and the only cycles are slides between the two partitions of
+a movement-phase pair (a, b) and (b, a), which are solved together.
+
+Each partition is a file of one byte per position (see the value encoding
+below). Files are memory mapped, so RAM use is bounded by the page cache
+rather than by the size of the partition, and the solve survives restarts:
+progress.txt records every finished partition and the last completed layer of
+the group in progress.
+
+A cyclic group is solved in layers: layer d decides every position whose
+distance to the end of the game is exactly d plies, by looking at children
+only. Positions are evaluated independently, so each layer is split across
+all cores, and re-running a layer after a crash gives the same result.
+*/
+
+#pragma once
+
+#include <map>
+#include <array>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Morris.hpp"
+#include "Ranking.hpp"
+#include "Values.hpp"
+
+// Builds the position (Player A to move) at 'index' of a partition
+template <typename Mask>
+inline Position<Mask> partitionPosition(const PositionIndexer<Mask>& indexer, const PartitionKey& key, uint64_t index) {
+    Position<Mask> pos;
+    indexer.position(key, index, pos.men[0], pos.men[1]);
+    pos.hand = {key.stmHand, key.oppHand};
+    pos.turn = Player::A;
+    return pos;
+}
+
+// Partitions below the minimum token count are lost outright and have no file
+template <typename Mask>
+inline bool isStored(const Rules<Mask>& rules, const PartitionKey& key) {
+    return key.stmMen + key.stmHand >= rules.minMen && key.oppMen + key.oppHand >= rules.minMen;
+}
+
+// Value of a position in a partition that is not stored: a loss if the side to move is
+// below the minimum. If only the opponent is, the game ended before this move with no
+// distance to count, and no move of the game leads there: kUnknown.
+template <typename Mask>
+constexpr uint8_t unstoredValue(const Rules<Mask>& rules, const PartitionKey& key) {
+    return key.stmMen + key.stmHand < rules.minMen ? 0 : kUnknown;
+}
+
+// Every partition the game can reach, grouped into solve units in dependency order.
+// With movementOnly, only partitions with empty hands are listed.
+template <typename Mask>
+std::vector<std::vector<PartitionKey>> solveOrder(const Rules<Mask>& rules, bool movementOnly) {
+    std::vector<PartitionKey> keys;
+    for (int stmHand = 0; stmHand <= rules.men; ++stmHand) {
+        // The side to move has placed as many tokens as the opponent (Player A to move)
+        // or one fewer (Player B to move)
+        for (int oppHand : {stmHand, stmHand - 1}) {
+            if (oppHand < 0 || (oppHand != stmHand && stmHand == 0)) continue;
+            if (movementOnly && (stmHand || oppHand)) continue;
+            for (int a = 0; a <= rules.men - stmHand; ++a)
+                for (int b = 0; b <= rules.men - oppHand; ++b) {
+                    if (rules.capture == CaptureRule::Win && (a != rules.men - stmHand || b != rules.men - oppHand))
+                        continue;
+                    PartitionKey key{a, stmHand, b, oppHand};
+                    if (isStored(rules, key) && a + b <= rules.points) keys.push_back(key);
+                }
+        }
+    }
+    std::sort(keys.begin(), keys.end(), [](const PartitionKey& x, const PartitionKey& y) {
+        return std::make_tuple(x.stmHand + x.oppHand, x.stmMen + x.oppMen, x) <
+               std::make_tuple(y.stmHand + y.oppHand, y.stmMen + y.oppMen, y);
+    });
+
+    std::vector<std::vector<PartitionKey>> groups;
+    for (const auto& key : keys) {
+        PartitionKey mirror{key.oppMen, 0, key.stmMen, 0};
+        bool cyclic = key.stmHand == 0 && key.oppHand == 0;
+        if (cyclic && mirror < key) continue; // Solved together with its mirror
+        groups.push_back({key});
+        if (cyclic && !(mirror == key)) groups.back().push_back(mirror);
+    }
+    return groups;
+}
+
+// A partition file mapped into memory
+struct MappedFile {
+    uint8_t* data = nullptr;
+    uint64_t size = 0;
+    int fd = -1;
+
+    bool open(const std::string& path, uint64_t bytes, bool writable) {
+        fd = ::open(path.c_str(), writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+        if (fd < 0) return false;
+        if (writable && ftruncate(fd, static_cast<off_t>(bytes)) != 0) return close(), false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) != bytes) return close(), false;
+        void* p = mmap(nullptr, bytes, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) return close(), false;
+        data = static_cast<uint8_t*>(p);
+        size = bytes;
+        return true;
+    }
+
+    void sync() {
+        if (data) msync(data, size, MS_SYNC);
+    }
+
+    void close() {
+        if (data) munmap(data, size);
+        if (fd >= 0) ::close(fd);
+        data = nullptr;
+        fd = -1;
+        size = 0;
+    }
+};
+
+// Runs body(begin, end) over [0, n) in chunks on 'threads' threads
+inline void parallelFor(uint64_t n, int threads, const std::function<void(uint64_t, uint64_t)>& body) {
+    const uint64_t chunk = 1 << 14;
+    std::atomic<uint64_t> next{0};
+    auto worker = [&] {
+        for (uint64_t begin; (begin = next.fetch_add(chunk)) < n;)
+            body(begin, std::min(n, begin + chunk));
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+}
+
+// Runs body(thread) on 'threads' threads, the calling thread being thread 0
+inline void runWorkers(int threads, const std::function<void(int)>& body) {
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(body, t);
+    body(0);
+    for (auto& t : pool) t.join();
+}
+
+// Solved partitions on disk, mapped on first use
+template <typename Mask>
+class TableStore {
+public:
+    // Partitions missing from 'dir' are read from 'solvedDir' if given
+    TableStore(const Rules<Mask>& rules, const PositionIndexer<Mask>& indexer, const std::string& dir,
+               const std::string& solvedDir = "")
+        : rules_(rules), indexer_(indexer), dir_(dir), solvedDir_(solvedDir) {}
+    ~TableStore() {
+        for (auto& f : files_) f.second.close();
+    }
+
+    std::string path(const PartitionKey& key) const { return dir_ + "/" + key.name() + ".bin"; }
+
+    // Values of a partition, or nullptr if it has not been solved
+    const uint8_t* values(const PartitionKey& key) {
+        auto it = files_.find(key);
+        if (it != files_.end()) return it->second.data;
+        MappedFile f;
+        if (!f.open(path(key), indexer_.size(key), false) &&
+            (solvedDir_.empty() || !f.open(solvedDir_ + "/" + key.name() + ".bin", indexer_.size(key), false)))
+            return nullptr;
+        files_[key] = f;
+        return f.data;
+    }
+
+    // Creates (or reopens) a partition for writing
+    uint8_t* create(const PartitionKey& key, bool& existed) {
+        release(key);
+        existed = access(path(key).c_str(), F_OK) == 0;
+        MappedFile f;
+        if (!f.open(path(key), indexer_.size(key), true)) return nullptr;
+        files_[key] = f;
+        return f.data;
+    }
+
+    void sync(const PartitionKey& key) {
+        auto it = files_.find(key);
+        if (it != files_.end()) it->second.sync();
+    }
+
+    void release(const PartitionKey& key) {
+        auto it = files_.find(key);
+        if (it == files_.end()) return;
+        it->second.close();
+        files_.erase(it);
+    }
+
+    // Value of any position; see unstoredValue() for partitions below the minimum token count
+    uint8_t probe(const Position<Mask>& pos) {
+        PartitionKey key = partitionOf(pos);
+        if (!isStored(rules_, key)) return unstoredValue(rules_, key);
+        const uint8_t* v = values(key);
+        int me = static_cast<int>(pos.turn);
+        return v ? v[indexer_.index(key, pos.men[me], pos.men[1 - me])] : kUnknown;
+    }
+
+private:
+    const Rules<Mask>& rules_;
+    const PositionIndexer<Mask>& indexer_;
+    std::string dir_;
+    std::string solvedDir_;
+    std::map<PartitionKey, MappedFile> files_;
+};
+
+// Finished partitions and the state of the group in progress, kept in progress.txt
+struct SolveProgress {
+    std::map<PartitionKey, int> maxDistance; // Finished partitions and their longest win/loss
+    std::vector<PartitionKey> group;         // Group in progress, empty if none
+    int layer = -1;                          // Last completed layer of that group
+
+    bool load(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) return false;
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream ls(line);
+            std::string tag;
+            ls >> tag;
+            PartitionKey k;
+            if (tag == "done" && ls >> k.stmMen >> k.stmHand >> k.oppMen >> k.oppHand) {
+                int d = 0;
+                ls >> d;
+                maxDistance[k] = d;
+            } else if (tag == "group") {
+                while (ls >> k.stmMen >> k.stmHand >> k.oppMen >> k.oppHand) group.push_back(k);
+            } else if (tag == "layer") {
+                ls >> layer;
+            }
+        }
+        return true;
+    }
+
+    // Written to a temporary file and renamed, so a crash never leaves half a checkpoint
+    bool save(const std::string& path) const {
+        std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::trunc);
+            for (const auto& d : maxDistance)
+                out << "done " << d.first.stmMen << ' ' << d.first.stmHand << ' ' << d.first.oppMen << ' '
+                    << d.first.oppHand << ' ' << d.second << '\n';
+            if (!group.empty()) {
+                out << "group";
+                for (const auto& k : group)
+                    out << ' ' << k.stmMen << ' ' << k.stmHand << ' ' << k.oppMen << ' ' << k.oppHand;
+                out << "\nlayer " << layer << '\n';
+            }
+            out.flush();
+            if (!out) return false;
+        }
+        return std::rename(tmp.c_str(), path.c_str()) == 0;
+    }
+};
+
+// What the children of a position say about it
+struct ChildSummary {
+    uint8_t minLoss = kUnknown; // Shortest child loss, kUnknown if none
+    uint8_t maxWin = 0;         // Longest child win
+    bool undecided = false;     // Some child is unknown or drawn
+    int children = 0;
+};
+
+// True if value 'v' agrees with the children of a position (and whether it has already
+// lost): a win in d has a child lost in d - 1 and none lost sooner, a loss in d has only
+// children won in at most d - 1 plies, and a draw has no lost child but some drawn one
+inline bool consistentValue(bool lost, const ChildSummary& s, uint8_t v) {
+    if (lost || s.children == 0) return v == 0;
+    if (v == kDraw) return s.minLoss == kUnknown && s.undecided;
+    if (isWinValue(v)) return s.minLoss == v - 1;
+    return isLossValue(v) && v > 0 && s.minLoss == kUnknown && !s.undecided && s.maxWin == v - 1;
+}
+
+// Solves a board partition by partition. Positions are read as Player A to move.
+template <typename Mask>
+class RetrogradeSolver {
+public:
+    using Report = std::function<void(const std::string&)>;
+    // Solves a whole cyclic group in one go (see ParallelRetrograde.hpp): fills the
+    // values of each partition of the group, whose children outside it are in store()
+    using CyclicSolver = std::function<bool(const std::vector<PartitionKey>&, const std::vector<uint8_t*>&, std::string&)>;
+
+    // Partitions are written to 'dir'; those this solve depends on may also be read from 'solvedDir'
+    RetrogradeSolver(const Rules<Mask>& rules, const PositionIndexer<Mask>& indexer, const std::string& dir, int threads,
+                     const std::string& solvedDir = "")
+        : rules_(rules), indexer_(indexer), dir_(dir), threads_(std::max(1, threads)), store_(rules, indexer, dir, solvedDir) {}
+
+    TableStore<Mask>& store() { return store_; }
+
+    // Replaces the layered solve of movement groups. Such a group is not checkpointed
+    // layer by layer, so an interrupted solve restarts the group from scratch.
+    void setCyclicSolver(const CyclicSolver& solver) { cyclicSolver_ = solver; }
+
+    // Solves every partition in order, resuming from progress.txt if present
+    bool solve(bool movementOnly, std::string& error, const Report& report) {
+        mkdir(dir_.c_str(), 0755);
+        const std::string progressPath = dir_ + "/progress.txt";
+        SolveProgress progress;
+        if (progress.load(progressPath))
+            report("Resuming: " + std::to_string(progress.maxDistance.size()) + " partitions already solved");
+
+        for (const auto& group : solveOrder(rules_, movementOnly)) {
+            if (progress.maxDistance.count(group[0])) continue;
+            int resumeLayer = (progress.group == group) ? progress.layer : -1;
+            if (!solveGroup(group, resumeLayer, progress, progressPath, error, report))
+                return false;
+        }
+        return true;
+    }
+
+    // Solves one group of solveOrder() whose dependencies are listed in 'solved' with
+    // their longest distance, checkpointing to progress.txt in this solver's directory
+    bool solveUnit(const std::vector<PartitionKey>& group, const std::map<PartitionKey, int>& solved, std::string& error,
+                   const Report& report) {
+        mkdir(dir_.c_str(), 0755);
+        const std::string progressPath = dir_ + "/progress.txt";
+        SolveProgress progress;
+        progress.load(progressPath);
+        if (progress.maxDistance.count(group[0])) return true;
+        int resumeLayer = (progress.group == group) ? progress.layer : -1;
+        for (const auto& d : solved) progress.maxDistance.insert(d);
+        return solveGroup(group, resumeLayer, progress, progressPath, error, report);
+    }
+
+    // How far summarize() needs to look
+    enum class Scan {
+        All,      // Every child
+        FindLoss, // Stop at the first child lost in exactly 'distance' plies
+        AllWins   // Stop at the first child that is not a win
+    };
+
+    // Summarises the values of the children of 'pos'
+    ChildSummary summarize(const Position<Mask>& pos, const std::array<const uint8_t*, 4>& childValues,
+                           const std::array<PartitionKey, 4>& childKeys, Scan scan = Scan::All, int distance = 0) const {
+        ChildSummary s;
+        Move moves[kMaxMoves];
+        int n = generateMoves(rules_, pos, moves);
+        s.children = n;
+        for (int i = 0; i < n; ++i) {
+            Position<Mask> child = applyMove(pos, moves[i]);
+            int slot = (moves[i].from < 0 ? 2 : 0) + (moves[i].remove >= 0 ? 1 : 0);
+            uint8_t v = 0; // Partitions without a file are below the minimum token count: lost
+            if (childValues[slot]) {
+                int me = static_cast<int>(child.turn);
+                v = childValues[slot][indexer_.index(childKeys[slot], child.men[me], child.men[1 - me])];
+            }
+            if (isLossValue(v)) {
+                s.minLoss = std::min(s.minLoss, v);
+                if ((scan == Scan::FindLoss && v == distance) || scan == Scan::AllWins) return s;
+            } else if (isWinValue(v)) {
+                s.maxWin = std::max(s.maxWin, v);
+            } else {
+                s.undecided = true;
+                if (scan == Scan::AllWins) return s;
+            }
+        }
+        return s;
+    }
+
+    // Child partitions of a partition, by move kind: slide, slide + capture, place, place + capture
+    std::array<PartitionKey, 4> childPartitions(const PartitionKey& k) const {
+        return {{{k.oppMen, k.oppHand, k.stmMen, k.stmHand},
+                 {k.oppMen - 1, k.oppHand, k.stmMen, k.stmHand},
+                 {k.oppMen, k.oppHand, k.stmMen + 1, k.stmHand - 1},
+                 {k.oppMen - 1, k.oppHand, k.stmMen + 1, k.stmHand - 1}}};
+    }
+
+    // True if a move of the given kind (see childPartitions) can lead to a stored partition
+    bool hasChildTable(const PartitionKey& key, int slot) const {
+        const PartitionKey ck = childPartitions(key)[slot];
+        // Placements (slots 2, 3) while tokens are in hand, slides (0, 1) after;
+        // captures (1, 3) only when a mill removes a token
+        bool reachable = (slot >= 2) == (key.stmHand > 0) && ck.stmMen >= 0 && ck.stmMen + ck.oppMen <= rules_.points &&
+                         (rules_.capture == CaptureRule::Remove || (slot & 1) == 0);
+        return reachable && isStored(rules_, ck);
+    }
+
+    // Maps the values of the partitions a partition can move into. Partitions of 'group'
+    // use 'groupValues', the others must be solved (listed in 'solved', whose longest
+    // distance raises 'bound'). Kinds of move the rules never allow are left null.
+    bool childTables(const PartitionKey& key, const std::vector<PartitionKey>& group,
+                     const std::vector<uint8_t*>& groupValues, const std::map<PartitionKey, int>& solved,
+                     std::array<const uint8_t*, 4>& values, int& bound, std::string& error) {
+        std::array<PartitionKey, 4> keys = childPartitions(key);
+        values.fill(nullptr);
+        for (int slot = 0; slot < 4; ++slot) {
+            const PartitionKey& ck = keys[slot];
+            if (!hasChildTable(key, slot)) continue;
+            auto inGroup = std::find(group.begin(), group.end(), ck);
+            if (inGroup != group.end()) {
+                values[slot] = groupValues[inGroup - group.begin()];
+                continue;
+            }
+            auto done = solved.find(ck);
+            values[slot] = done != solved.end() ? store_.values(ck) : nullptr;
+            if (!values[slot]) {
+                error = "partition " + ck.name() + " is needed by " + key.name() + " but has not been solved";
+                return false;
+            }
+            bound = std::max(bound, done->second);
+        }
+        return true;
+    }
+
+    // Value of a position whose children are all solved
+    static uint8_t valueOf(const ChildSummary& s) {
+        if (s.children == 0) return 0;
+        if (s.minLoss != kUnknown) return s.minLoss + 1;
+        if (s.undecided) return kDraw;
+        return s.maxWin + 1;
+    }
+
+    // True if value 'v' of 'pos' agrees with the values of its children (see consistentValue)
+    bool consistent(const Position<Mask>& pos, uint8_t v, const std::array<const uint8_t*, 4>& childValues,
+                    const std::array<PartitionKey, 4>& childKeys) const {
+        if (isLost(rules_, pos)) return v == 0;
+        return consistentValue(false, summarize(pos, childValues, childKeys), v);
+    }
+
+private:
+    struct Work {
+        PartitionKey key;
+        uint8_t* values = nullptr;
+        std::array<PartitionKey, 4> childKeys;
+        std::array<const uint8_t*, 4> childValues{};
+    };
+
+    bool solveGroup(const std::vector<PartitionKey>& group, int resumeLayer, SolveProgress& progress,
+                    const std::string& progressPath, std::string& error, const Report& report) {
+        std::vector<Work> work(group.size());
+        int bound = 0; // Longest distance found in the partitions this group depends on
+        for (std::size_t i = 0; i < group.size(); ++i) {
+            bool existed = false;
+            work[i].key = group[i];
+            work[i].values = store_.create(group[i], existed);
+            if (!work[i].values) {
+                error = "cannot map " + store_.path(group[i]);
+                return false;
+            }
+            if (!existed) resumeLayer = -1;
+        }
+        std::vector<uint8_t*> groupValues;
+        for (auto& w : work) groupValues.push_back(w.values);
+        for (auto& w : work) {
+            w.childKeys = childPartitions(w.key);
+            if (!childTables(w.key, group, groupValues, progress.maxDistance, w.childValues, bound, error)) return false;
+        }
+
+        std::string names;
+        uint64_t total = 0;
+        for (const auto& k : group) {
+            names += (names.empty() ? "" : " + ") + k.name();
+            total += indexer_.size(k);
+        }
+        report("Solving " + names + " (" + std::to_string(total) + " positions)");
+
+        progress.group = group;
+        bool cyclic = group[0].stmHand == 0 && group[0].oppHand == 0;
+
+        if (cyclic && cyclicSolver_) {
+            std::vector<uint8_t*> values;
+            for (auto& w : work) values.push_back(w.values);
+            if (!cyclicSolver_(group, values, error)) return false;
+        } else if (resumeLayer < 0) {
+            // Layer 0: terminal positions; everything else starts unknown. Acyclic groups
+            // have every child solved already and are finished in this single pass.
+            for (auto& w : work) {
+                parallelFor(indexer_.size(w.key), threads_, [&](uint64_t begin, uint64_t end) {
+                    for (uint64_t i = begin; i < end; ++i) {
+                        Position<Mask> pos = partitionPosition(indexer_, w.key, i);
+                        if (isLost(rules_, pos)) {
+                            w.values[i] = 0;
+                            continue;
+                        }
+                        if (cyclic) {
+                            Move moves[kMaxMoves];
+                            w.values[i] = generateMoves(rules_, pos, moves) ? kUnknown : 0;
+                            continue;
+                        }
+                        w.values[i] = valueOf(summarize(pos, w.childValues, w.childKeys));
+                    }
+                });
+            }
+            resumeLayer = 0;
+            if (!checkpoint(work, progress, resumeLayer, progressPath, error)) return false;
+        } else {
+            report("  resuming after layer " + std::to_string(resumeLayer));
+        }
+
+        if (cyclic && !cyclicSolver_) {
+            for (int d = resumeLayer + 1;; ++d) {
+                if (d > kMaxDistance) {
+                    error = "distances exceed " + std::to_string(kMaxDistance) + " plies";
+                    return false;
+                }
+                std::atomic<uint64_t> decided{0};
+                for (auto& w : work) {
+                    parallelFor(indexer_.size(w.key), threads_, [&](uint64_t begin, uint64_t end) {
+                        uint64_t count = 0;
+                        for (uint64_t i = begin; i < end; ++i) {
+                            // A run killed before its checkpoint may have stored this layer already
+                            if (w.values[i] == d) ++count;
+                            if (w.values[i] != kUnknown) continue;
+                            Position<Mask> pos = partitionPosition(indexer_, w.key, i);
+                            ChildSummary s = summarize(pos, w.childValues, w.childKeys,
+                                                       (d & 1) ? Scan::FindLoss : Scan::AllWins, d - 1);
+                            bool done = (d & 1) ? s.minLoss == d - 1
+                                                : (!s.undecided && s.minLoss == kUnknown && s.maxWin == d - 1);
+                            if (done) {
+                                w.values[i] = static_cast<uint8_t>(d);
+                                ++count;
+                            }
+                        }
+                        decided += count;
+                    });
+                }
+                if (!checkpoint(work, progress, d, progressPath, error)) return false;
+                if (decided) report("  layer " + std::to_string(d) + ": " + std::to_string(decided.load()) + " positions");
+                if (decided == 0 && d > bound) break;
+            }
+            for (auto& w : work) {
+                parallelFor(indexer_.size(w.key), threads_, [&](uint64_t begin, uint64_t end) {
+                    for (uint64_t i = begin; i < end; ++i)
+                        if (w.values[i] == kUnknown) w.values[i] = kDraw;
+                });
+            }
+        }
+
+        for (auto& w : work) {
+            uint64_t size = indexer_.size(w.key);
+            std::array<uint64_t, 3> wdl{};
+            int longest = 0;
+            for (uint64_t i = 0; i < size; ++i) {
+                uint8_t v = w.values[i];
+                wdl[v == kDraw ? 1 : isWinValue(v) ? 0 : 2]++;
+                if (v != kDraw) longest = std::max<int>(longest, v);
+            }
+            store_.sync(w.key);
+            progress.maxDistance[w.key] = longest;
+            report("  " + w.key.name() + ": " + std::to_string(wdl[0]) + " wins, " + std::to_string(wdl[1]) +
+                   " draws, " + std::to_string(wdl[2]) + " losses, longest " + std::to_string(longest) + " plies");
+        }
+        progress.group.clear();
+        progress.layer = -1;
+        if (!progress.save(progressPath)) {
+            error = "cannot write " + progressPath;
+            return false;
+        }
+        return true;
+    }
+
+    bool checkpoint(std::vector<Work>& work, SolveProgress& progress, int layer,
+                    const std::string& progressPath, std::string& error) {
+        for (auto& w : work) store_.sync(w.key);
+        progress.layer = layer;
+        if (!progress.save(progressPath)) {
+            error = "cannot write " + progressPath;
+            return false;
+        }
+        return true;
+    }
+
+    const Rules<Mask>& rules_;
+    const PositionIndexer<Mask>& indexer_;
+    std::string dir_;
+    int threads_;
+    TableStore<Mask> store_;
+    CyclicSolver cyclicSolver_;
+};
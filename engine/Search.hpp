@@ -0,0 +1,300 @@
+/*
+Search - best moves from a game-tree search or from perfect-play tables
+
+Searcher runs an iterative-deepening alpha-beta (negamax) search with a
+transposition table keyed by Zobrist hashes (see Morris.hpp). Leaves are
+scored by material (tokens on the board and in hand) and by open mills: two
+tokens of one player and an empty point on the same line. Lost positions
+score -kMateScore plus the ply they are reached at, so nearer wins score
+higher. A search stops at a depth, a time limit or a stop flag. Whatever the
+reason, it returns the best move of the last depth it finished.
+
+BackgroundSearch runs searches on a worker thread, so a caller that must not
+wait (the game's render loop) starts one and polls for its result. Starting
+another abandons the one still running.
+
+tableMove() picks the best move from a value probe instead, for boards that
+have a solved table (CompileTimeSolve.hpp, Tablebase.hpp): the fastest win,
+else a draw, else the slowest loss.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include "Morris.hpp"
+#include "Values.hpp"
+
+constexpr int kMateScore = 30000;
+constexpr int kMaxSearchDepth = 64;
+
+// When a search stops: at a depth, after some time, or when *stop turns true
+struct SearchLimits {
+    int depth = kMaxSearchDepth;
+    double seconds = 0;                        // 0 for no time limit
+    const std::atomic<bool>* stop = nullptr;
+};
+
+struct SearchResult {
+    Move best;          // to == -1 if the side to move has no move
+    int score = 0;      // For the side to move; see scoreName()
+    int depth = 0;      // Last depth searched to the end
+    uint64_t nodes = 0;
+    double seconds = 0;
+};
+
+// True if a score is a forced win or loss rather than an estimate
+inline bool isMateScore(int score) { return std::abs(score) > kMateScore - 1000; }
+
+// Readable form of a score, e.g. "win in 5" or "+120"
+inline std::string scoreName(int score) {
+    if (isMateScore(score))
+        return std::string(score > 0 ? "win" : "loss") + " in " + std::to_string(kMateScore - std::abs(score));
+    return (score > 0 ? "+" : "") + std::to_string(score);
+}
+
+template <typename Mask>
+class Searcher {
+public:
+    explicit Searcher(const Rules<Mask>& rules, std::size_t tableEntries = std::size_t(1) << 20)
+        : rules_(rules), table_(std::max<std::size_t>(1, std::size_t(1) << (63 - __builtin_clzll(tableEntries | 1)))) {}
+
+    SearchResult search(const Position<Mask>& pos, const SearchLimits& limits) {
+        auto begin = std::chrono::steady_clock::now();
+        limits_ = limits;
+        deadline_ = begin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                std::chrono::duration<double>(limits.seconds));
+        stopped_ = false;
+        nodes_ = 0;
+        ++age_;
+        SearchResult result;
+        Move moves[kMaxMoves];
+        int n = isLost(rules_, pos) ? 0 : generateMoves(rules_, pos, moves);
+        if (n > 0) result.best = moves[0];
+        else result.score = -kMateScore;
+        if (n > 0) {
+            uint64_t hash = hashPosition(keys_, pos);
+            for (int depth = 1; depth <= std::min(limits.depth, kMaxSearchDepth); ++depth) {
+                int score = negamax(pos, hash, depth, -kMateScore - 1, kMateScore + 1, 0);
+                if (stopped_) break;
+                result.best = rootBest_;
+                result.score = score;
+                result.depth = depth;
+                // A mate within this depth is the nearest: deeper searches find the same one.
+                // One from the table may lie further than the depth, and a nearer one with it.
+                if (isMateScore(score) && kMateScore - std::abs(score) <= depth) break;
+            }
+        }
+        result.nodes = nodes_;
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        return result;
+    }
+
+private:
+    enum Bound : uint8_t { Exact, Lower, Upper };
+    struct Entry { // 16 bytes
+        uint64_t key = 0;
+        int16_t score = 0;
+        int8_t depth = -1;
+        Bound bound = Exact;
+        Move move;
+        uint8_t age = 0;
+    };
+
+    int evaluate(const Position<Mask>& pos) const {
+        int me = static_cast<int>(pos.turn), op = 1 - me;
+        int score = 100 * (countMen(pos.men[me]) + pos.hand[me] - countMen(pos.men[op]) - pos.hand[op]);
+        for (Mask m : rules_.mills) {
+            int mine = countMen(Mask(m & pos.men[me])), theirs = countMen(Mask(m & pos.men[op]));
+            if (mine == 2 && theirs == 0) score += 10;
+            if (theirs == 2 && mine == 0) score -= 10;
+        }
+        return score;
+    }
+
+    bool outOfTime() {
+        if ((nodes_ & 1023) == 0 &&
+            ((limits_.stop && limits_.stop->load(std::memory_order_relaxed)) ||
+             (limits_.seconds > 0 && std::chrono::steady_clock::now() >= deadline_)))
+            stopped_ = true;
+        return stopped_;
+    }
+
+    int negamax(const Position<Mask>& pos, uint64_t hash, int depth, int alpha, int beta, int ply) {
+        ++nodes_;
+        if (outOfTime()) return 0;
+        if (isLost(rules_, pos)) return -kMateScore + ply;
+        Move moves[kMaxMoves];
+        int n = generateMoves(rules_, pos, moves);
+        if (n == 0) return -kMateScore + ply;
+        if (depth == 0) return evaluate(pos);
+
+        // Mate scores are stored relative to this node, so they stay right wherever it recurs
+        Entry& e = table_[hash & (table_.size() - 1)];
+        int first = 0;
+        if (e.key == hash) {
+            if (e.depth >= depth) {
+                int score = e.score;
+                if (isMateScore(score)) score += score > 0 ? -ply : ply;
+                if (e.bound == Exact || (e.bound == Lower && score >= beta) || (e.bound == Upper && score <= alpha))
+                    if (ply > 0) return score;
+            }
+            for (int i = 0; i < n; ++i)
+                if (moves[i] == e.move) first = i;
+        }
+        // The stored best move first, then moves that take a token
+        std::swap(moves[0], moves[first]);
+        std::partition(moves + 1, moves + n, [](const Move& m) { return m.remove >= 0; });
+
+        int best = -kMateScore - 1, alpha0 = alpha;
+        Move bestMove = moves[0];
+        for (int i = 0; i < n; ++i) {
+            int score = -negamax(applyMove(pos, moves[i]), updateHash(keys_, hash, pos, moves[i]), depth - 1, -beta, -alpha, ply + 1);
+            if (stopped_) return 0;
+            if (score > best) {
+                best = score;
+                bestMove = moves[i];
+            }
+            alpha = std::max(alpha, score);
+            if (alpha >= beta) break;
+        }
+        if (ply == 0) rootBest_ = bestMove;
+
+        // Replaces entries from older searches, or searched less deep
+        if (e.key != hash && e.age == age_ && e.depth > depth) return best;
+        e.key = hash;
+        e.score = static_cast<int16_t>(isMateScore(best) ? best + (best > 0 ? ply : -ply) : best);
+        e.depth = static_cast<int8_t>(depth);
+        e.bound = best <= alpha0 ? Upper : best >= beta ? Lower : Exact;
+        e.move = bestMove;
+        e.age = age_;
+        return best;
+    }
+
+    const Rules<Mask>& rules_;
+    ZobristKeys<Mask> keys_;
+    std::vector<Entry> table_;
+    SearchLimits limits_;
+    std::chrono::steady_clock::time_point deadline_;
+    bool stopped_ = false;
+    Move rootBest_;
+    uint64_t nodes_ = 0;
+    uint8_t age_ = 0;
+};
+
+// Searches on a worker thread, started on the first search. Everything but the worker
+// only takes the lock briefly, and poll() is a single atomic load until a result is in.
+template <typename Mask>
+class BackgroundSearch {
+public:
+    explicit BackgroundSearch(const Rules<Mask>& rules, std::size_t tableEntries = std::size_t(1) << 20)
+        : rules_(rules), tableEntries_(tableEntries) {}
+    BackgroundSearch(const BackgroundSearch&) = delete;
+    BackgroundSearch& operator=(const BackgroundSearch&) = delete;
+
+    ~BackgroundSearch() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            quit_ = true;
+            stop_ = true;
+        }
+        wake_.notify_one();
+        if (worker_.joinable()) worker_.join();
+    }
+
+    // Starts searching 'pos', abandoning the search still running, if any
+    void start(const Position<Mask>& pos, const SearchLimits& limits) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!worker_.joinable()) worker_ = std::thread([this] { run(); });
+            job_ = pos;
+            limits_ = limits;
+            pending_ = true;
+            ++started_;
+            stop_ = true;
+            ready_ = false;
+        }
+        wake_.notify_one();
+    }
+
+    // Abandons the search still running, if any; its result is never reported
+    void cancel() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = false;
+        ++started_;
+        stop_ = true;
+        ready_ = false;
+    }
+
+    // True, once, when the search started last has finished, with its result in 'out'
+    bool poll(SearchResult& out) {
+        if (!ready_.load(std::memory_order_acquire)) return false;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!ready_) return false;
+        out = result_;
+        ready_ = false;
+        return true;
+    }
+
+private:
+    void run() {
+        Searcher<Mask> searcher(rules_, tableEntries_);
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            wake_.wait(lock, [this] { return quit_ || pending_; });
+            if (quit_) return;
+            Position<Mask> pos = job_;
+            SearchLimits limits = limits_;
+            limits.stop = &stop_;
+            uint64_t id = started_;
+            pending_ = false;
+            stop_ = false;
+            lock.unlock();
+            SearchResult result = searcher.search(pos, limits);
+            lock.lock();
+            if (id == started_) {
+                result_ = result;
+                ready_ = true;
+            }
+        }
+    }
+
+    const Rules<Mask>& rules_;
+    std::size_t tableEntries_;
+    std::thread worker_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    Position<Mask> job_;
+    SearchLimits limits_;
+    SearchResult result_;
+    uint64_t started_ = 0; // Searches started or cancelled; only the last one reports
+    bool pending_ = false, quit_ = false;
+    std::atomic<bool> stop_{false}, ready_{false};
+};
+
+// The best move by probing the value of every move's result, with probe(position)
+// giving a value for the side to move there. Sets 'value' to the value of the position
+// the move wins, draws or loses by (kUnknown with no moves). to == -1 if there are none.
+template <typename Mask, typename Probe>
+Move tableMove(const Rules<Mask>& rules, const Position<Mask>& pos, Probe&& probe, uint8_t* value = nullptr) {
+    Move moves[kMaxMoves], best;
+    int n = isLost(rules, pos) ? 0 : generateMoves(rules, pos, moves);
+    uint8_t bestValue = kUnknown;
+    for (int i = 0; i < n; ++i) {
+        uint8_t v = parentValue(probe(applyMove(pos, moves[i])));
+        if (best.to < 0 || valueRank(v) > valueRank(bestValue)) {
+            best = moves[i];
+            bestValue = v;
+        }
+    }
+    if (value) *value = bestValue;
+    return best;
+}
@@ -0,0 +1,412 @@
+/*
+Sharded solving - one solve split across worker processes on the same machine
+
+A solve that needs more memory than one process should hold is cut into
+shards, each run as a separate local process that writes its own files:
+
+  - a partition solved in one pass (tokens still in hand) is cut into index
+    ranges; a worker maps the solved partitions it moves into, evaluates its
+    range and writes shards/<partition>.<begin>.bin;
+  - a movement group (one partition or a mirrored pair) cannot be cut, since
+    its positions depend on each other, and is solved whole by one worker in
+    shards/<partition>/, where it checkpoints like a normal solve.
+
+The coordinator sizes every shard so its estimated footprint (the partitions
+it maps or allocates) fits the memory budget of one process, runs at most
+'processes' workers at a time, and starts a group only once every partition
+it depends on has been merged. Each worker writes a checksum next to every
+file. Merging checks the checksum and the size of each shard, copies or
+renames it into place, and checks the merged partition: no value is left
+unknown, and a sample of positions agrees with the values of its children.
+Only then is the partition recorded in progress.txt, so an interrupted
+sharded solve resumes like a normal one.
+
+Workers are started with fork/exec of the running program (see Solve.cpp);
+everything is files on the local disk, with no network involved.
+*/
+
+#pragma once
+
+#include <cerrno>
+#include <sys/wait.h>
+#include "BitslicedRetrograde.hpp"
+
+// FNV-1a checksum of a shard file
+inline uint64_t shardChecksum(const uint8_t* data, uint64_t size) {
+    uint64_t h = 1469598103934665603ull;
+    for (uint64_t i = 0; i < size; ++i) h = (h ^ data[i]) * 1099511628211ull;
+    return h;
+}
+
+inline bool writeChecksum(const std::string& path, const uint8_t* data, uint64_t size) {
+    std::ofstream out(path + ".sum", std::ios::trunc);
+    out << std::hex << shardChecksum(data, size) << '\n';
+    return static_cast<bool>(out);
+}
+
+inline bool checksumMatches(const std::string& path, const uint8_t* data, uint64_t size) {
+    std::ifstream in(path + ".sum");
+    uint64_t sum = 0;
+    return static_cast<bool>(in >> std::hex >> sum) && sum == shardChecksum(data, size);
+}
+
+// Cyclic group solver a worker plugs into RetrogradeSolver
+enum class CyclicMethod { Layered, Backward, Bitsliced };
+
+// Rough bytes per position of a movement group while it is solved, on top of the
+// partitions it captures into
+inline uint64_t bytesPerPosition(CyclicMethod method) {
+    switch (method) {
+    case CyclicMethod::Backward: return 3;   // Values, child counts, decided bits, pending lists
+    case CyclicMethod::Bitsliced: return 48; // Values and the slot-major child table
+    default: return 1;                       // Values only, memory mapped
+    }
+}
+
+// A piece of the solve run by one worker
+struct Shard {
+    std::vector<PartitionKey> group; // A group of solveOrder()
+    bool cyclic = false;             // Whole movement group, or the range below of group[0]
+    uint64_t begin = 0, end = 0;
+    uint64_t memory = 0;             // Estimated footprint in bytes
+
+    std::string file(const std::string& dir) const {
+        return dir + "/shards/" + group[0].name() + (cyclic ? "" : "." + std::to_string(begin) + ".bin");
+    }
+};
+
+// Runs one shard in this process: 'dir' is the output directory of the whole solve
+template <typename Mask>
+bool runShard(const Rules<Mask>& rules, const PositionIndexer<Mask>& indexer, const std::string& dir, const Shard& shard,
+              CyclicMethod method, int threads, std::string& error) {
+    SolveProgress progress;
+    if (!progress.load(dir + "/progress.txt")) {
+        error = "cannot read " + dir + "/progress.txt";
+        return false;
+    }
+    mkdir((dir + "/shards").c_str(), 0755);
+    auto quiet = [](const std::string&) {};
+
+    if (shard.cyclic) {
+        const std::string out = shard.file(dir);
+        RetrogradeSolver<Mask> solver(rules, indexer, out, threads, dir);
+        ParallelRetrograde<Mask> backward(rules, indexer, solver.store(), threads);
+        BitslicedRetrograde<Mask> sliced(rules, indexer, solver.store(), threads);
+        if (method == CyclicMethod::Backward)
+            solver.setCyclicSolver([&](const std::vector<PartitionKey>& g, const std::vector<uint8_t*>& v,
+                                       std::string& err) { return backward.solve(g, v, err); });
+        if (method == CyclicMethod::Bitsliced)
+            solver.setCyclicSolver([&](const std::vector<PartitionKey>& g, const std::vector<uint8_t*>& v,
+                                       std::string& err) { return sliced.solve(g, v, err); });
+        if (!solver.solveUnit(shard.group, progress.maxDistance, error, quiet)) return false;
+        for (const auto& key : shard.group) {
+            const uint8_t* values = solver.store().values(key);
+            if (!values || !writeChecksum(solver.store().path(key), values, indexer.size(key))) {
+                error = "cannot write the checksum of " + solver.store().path(key);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const PartitionKey& key = shard.group[0];
+    RetrogradeSolver<Mask> solver(rules, indexer, dir, threads);
+    std::array<const uint8_t*, 4> childValues;
+    std::array<PartitionKey, 4> childKeys = solver.childPartitions(key);
+    int bound = 0;
+    if (!solver.childTables(key, shard.group, {nullptr}, progress.maxDistance, childValues, bound, error)) return false;
+
+    const std::string path = shard.file(dir);
+    MappedFile out;
+    if (!out.open(path, shard.end - shard.begin, true)) {
+        error = "cannot map " + path;
+        return false;
+    }
+    parallelFor(shard.end - shard.begin, threads, [&](uint64_t begin, uint64_t end) {
+        for (uint64_t i = begin; i < end; ++i) {
+            Position<Mask> pos = partitionPosition(indexer, key, shard.begin + i);
+            out.data[i] = isLost(rules, pos) ? 0 : solver.valueOf(solver.summarize(pos, childValues, childKeys));
+        }
+    });
+    out.sync();
+    bool ok = writeChecksum(path, out.data, out.size);
+    out.close();
+    if (!ok) error = "cannot write " + path + ".sum";
+    return ok;
+}
+
+// Splits a solve into shards and runs them as worker processes
+template <typename Mask>
+class ShardedSolve {
+public:
+    using Report = std::function<void(const std::string&)>;
+    // Command line that runs one shard (see Solve.cpp)
+    using WorkerArgs = std::function<std::vector<std::string>(const Shard&)>;
+
+    ShardedSolve(const Rules<Mask>& rules, const PositionIndexer<Mask>& indexer, const std::string& dir, int processes,
+                 uint64_t budget, CyclicMethod method)
+        : rules_(rules), indexer_(indexer), dir_(dir), processes_(std::max(1, processes)), budget_(budget),
+          method_(method) {}
+
+    bool solve(bool movementOnly, const WorkerArgs& workerArgs, std::string& error, const Report& report) {
+        mkdir(dir_.c_str(), 0755);
+        mkdir((dir_ + "/shards").c_str(), 0755);
+        const std::string progressPath = dir_ + "/progress.txt";
+        SolveProgress progress;
+        if (progress.load(progressPath))
+            report("Resuming: " + std::to_string(progress.maxDistance.size()) + " partitions already solved");
+        progress.group.clear(); // Groups in progress are checkpointed by their workers
+        if (!progress.save(progressPath)) {
+            error = "cannot write " + progressPath;
+            return false;
+        }
+
+        std::vector<std::vector<PartitionKey>> waiting;
+        for (const auto& group : solveOrder(rules_, movementOnly))
+            if (!progress.maxDistance.count(group[0])) waiting.push_back(group);
+
+        std::vector<Shard> queue;
+        std::map<pid_t, Shard> running;
+        std::map<std::vector<PartitionKey>, std::vector<Shard>> shards; // Per started group
+        std::map<std::vector<PartitionKey>, int> remaining;
+        bool failed = false;
+
+        while (!failed && (!waiting.empty() || !queue.empty() || !running.empty())) {
+            // Groups whose dependencies are all merged are cut into shards
+            for (auto it = waiting.begin(); it != waiting.end();) {
+                if (!ready(*it, progress)) {
+                    ++it;
+                    continue;
+                }
+                std::vector<Shard> cut;
+                if (!plan(*it, cut, error)) return false;
+                shards[*it] = cut;
+                remaining[*it] = static_cast<int>(cut.size());
+                queue.insert(queue.end(), cut.begin(), cut.end());
+                it = waiting.erase(it);
+            }
+            while (!queue.empty() && static_cast<int>(running.size()) < processes_) {
+                const Shard& shard = queue.front();
+                pid_t pid = launch(workerArgs(shard));
+                if (pid < 0) {
+                    error = "cannot start a worker process";
+                    failed = true;
+                    break;
+                }
+                report("  started " + describe(shard) + " (" + std::to_string(shard.memory >> 20) + " MB)");
+                running[pid] = shard;
+                queue.erase(queue.begin());
+            }
+            if (running.empty()) {
+                if (!failed && queue.empty() && !waiting.empty()) {
+                    error = "partition " + waiting[0][0].name() + " depends on a partition that is not solved";
+                    return false;
+                }
+                continue;
+            }
+
+            int status = 0;
+            pid_t pid = waitpid(-1, &status, 0);
+            if (pid < 0) {
+                if (errno == EINTR) continue;
+                error = "lost track of the worker processes";
+                return false;
+            }
+            auto done = running.find(pid);
+            if (done == running.end()) continue;
+            Shard shard = done->second;
+            running.erase(done);
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                error = "worker for " + describe(shard) + " failed";
+                failed = true;
+                break;
+            }
+            report("  finished " + describe(shard));
+            if (--remaining[shard.group] > 0) continue;
+            if (!merge(shard.group, shards[shard.group], progress, error, report) || !progress.save(progressPath)) {
+                if (error.empty()) error = "cannot write " + progressPath;
+                failed = true;
+            }
+        }
+
+        // On failure, let the other workers finish: a cyclic group resumes from its own
+        // progress on the next run, while range shards are solved again
+        for (auto& r : running) waitpid(r.first, nullptr, 0);
+        return !failed;
+    }
+
+private:
+    // Every sample of merged positions that is checked against its children
+    static constexpr uint64_t kVerifyStride = 61;
+
+    static std::string describe(const Shard& shard) {
+        std::string name;
+        for (const auto& k : shard.group) name += (name.empty() ? "" : " + ") + k.name();
+        if (!shard.cyclic) name += " [" + std::to_string(shard.begin) + ", " + std::to_string(shard.end) + ")";
+        return name;
+    }
+
+    // Solved partitions outside 'group' that it moves into
+    std::vector<PartitionKey> dependencies(const std::vector<PartitionKey>& group) const {
+        RetrogradeSolver<Mask> solver(rules_, indexer_, dir_, 1);
+        std::vector<PartitionKey> deps;
+        for (const auto& key : group)
+            for (int slot = 0; slot < 4; ++slot) {
+                PartitionKey ck = solver.childPartitions(key)[slot];
+                if (solver.hasChildTable(key, slot) && std::find(group.begin(), group.end(), ck) == group.end() &&
+                    std::find(deps.begin(), deps.end(), ck) == deps.end())
+                    deps.push_back(ck);
+            }
+        return deps;
+    }
+
+    bool ready(const std::vector<PartitionKey>& group, const SolveProgress& progress) const {
+        for (const auto& dep : dependencies(group))
+            if (!progress.maxDistance.count(dep)) return false;
+        return true;
+    }
+
+    bool plan(const std::vector<PartitionKey>& group, std::vector<Shard>& out, std::string& error) const {
+        uint64_t childBytes = 0;
+        for (const auto& dep : dependencies(group)) childBytes += indexer_.size(dep);
+        bool cyclic = group[0].stmHand == 0 && group[0].oppHand == 0;
+        const uint64_t mb = 1 << 20;
+
+        if (cyclic) {
+            Shard shard;
+            shard.group = group;
+            shard.cyclic = true;
+            for (const auto& key : group) shard.memory += indexer_.size(key) * bytesPerPosition(method_);
+            shard.memory += childBytes;
+            if (shard.memory > budget_) {
+                error = describe(shard) + " needs about " + std::to_string((shard.memory + mb - 1) / mb) +
+                        " MB in one process, over the budget of " + std::to_string(budget_ / mb) + " MB";
+                return false;
+            }
+            out.push_back(shard);
+            return true;
+        }
+
+        const uint64_t size = indexer_.size(group[0]);
+        const uint64_t minShard = 1 << 16;
+        if (childBytes + std::min(size, minShard) > budget_) {
+            error = group[0].name() + " moves into " + std::to_string((childBytes + mb - 1) / mb) +
+                    " MB of solved partitions, over the budget of " + std::to_string(budget_ / mb) + " MB";
+            return false;
+        }
+        // As few shards as the budget allows, but enough to keep every process busy
+        uint64_t count = (size + (budget_ - childBytes) - 1) / (budget_ - childBytes);
+        count = std::max<uint64_t>(count, std::min<uint64_t>(processes_, size / minShard));
+        count = std::max<uint64_t>(count, 1);
+        for (uint64_t i = 0; i < count; ++i) {
+            Shard shard;
+            shard.group = group;
+            shard.begin = size * i / count;
+            shard.end = size * (i + 1) / count;
+            shard.memory = childBytes + (shard.end - shard.begin);
+            out.push_back(shard);
+        }
+        return true;
+    }
+
+    static pid_t launch(const std::vector<std::string>& args) {
+        pid_t pid = fork();
+        if (pid != 0) return pid;
+        std::vector<char*> argv;
+        for (const auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+        argv.push_back(nullptr);
+        execv("/proc/self/exe", argv.data());
+        _exit(127);
+    }
+
+    // Moves the shards of a finished group into place and checks the result
+    bool merge(const std::vector<PartitionKey>& group, const std::vector<Shard>& shards, SolveProgress& progress,
+               std::string& error, const Report& report) {
+        RetrogradeSolver<Mask> solver(rules_, indexer_, dir_, 1);
+        TableStore<Mask>& store = solver.store();
+        for (const auto& key : group) store.release(key);
+
+        if (shards[0].cyclic) {
+            for (const auto& key : group) {
+                std::string from = shards[0].file(dir_) + "/" + key.name() + ".bin";
+                MappedFile f;
+                bool ok = f.open(from, indexer_.size(key), false) && checksumMatches(from, f.data, f.size);
+                f.close();
+                if (!ok || std::rename(from.c_str(), store.path(key).c_str()) != 0) {
+                    error = "shard " + from + " is missing or corrupt";
+                    return false;
+                }
+                std::remove((from + ".sum").c_str());
+            }
+            std::remove((shards[0].file(dir_) + "/progress.txt").c_str());
+            rmdir(shards[0].file(dir_).c_str());
+        } else {
+            const PartitionKey& key = group[0];
+            bool existed = false;
+            uint8_t* values = store.create(key, existed);
+            if (!values) {
+                error = "cannot map " + store.path(key);
+                return false;
+            }
+            uint64_t covered = 0;
+            for (const auto& shard : shards) {
+                MappedFile f;
+                std::string path = shard.file(dir_);
+                bool ok = shard.begin == covered && f.open(path, shard.end - shard.begin, false) &&
+                          checksumMatches(path, f.data, f.size);
+                if (ok) std::memcpy(values + shard.begin, f.data, f.size);
+                f.close();
+                if (!ok) {
+                    error = "shard " + path + " is missing or corrupt";
+                    return false;
+                }
+                covered = shard.end;
+            }
+            if (covered != indexer_.size(key)) {
+                error = "the shards of " + key.name() + " do not cover it";
+                return false;
+            }
+            store.sync(key);
+            store.release(key);
+            for (const auto& shard : shards) {
+                std::remove(shard.file(dir_).c_str());
+                std::remove((shard.file(dir_) + ".sum").c_str());
+            }
+        }
+
+        // The merged group: every value is final, and sampled positions agree with their children
+        std::vector<uint8_t*> groupValues;
+        for (const auto& key : group) groupValues.push_back(const_cast<uint8_t*>(store.values(key)));
+        for (std::size_t g = 0; g < group.size(); ++g) {
+            const PartitionKey& key = group[g];
+            const uint8_t* values = groupValues[g];
+            std::array<const uint8_t*, 4> childValues;
+            int bound = 0;
+            if (!values || !solver.childTables(key, group, groupValues, progress.maxDistance, childValues, bound, error))
+                return false;
+            std::array<PartitionKey, 4> childKeys = solver.childPartitions(key);
+            int longest = 0;
+            for (uint64_t i = 0; i < indexer_.size(key); ++i) {
+                uint8_t v = values[i];
+                bool bad = v == kUnknown ||
+                           (i % kVerifyStride == 0 &&
+                            !solver.consistent(partitionPosition(indexer_, key, i), v, childValues, childKeys));
+                if (bad) {
+                    error = "merged " + key.name() + " is inconsistent at index " + std::to_string(i);
+                    return false;
+                }
+                if (v != kDraw) longest = std::max<int>(longest, v);
+            }
+            progress.maxDistance[key] = longest;
+            report("  merged " + key.name() + ", longest " + std::to_string(longest) + " plies");
+        }
+        return true;
+    }
+
+    const Rules<Mask>& rules_;
+    const PositionIndexer<Mask>& indexer_;
+    std::string dir_;
+    int processes_;
+    uint64_t budget_;
+    CyclicMethod method_;
+};
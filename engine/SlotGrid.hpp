@@ -0,0 +1,74 @@
+/*
+Slot grid - constant-time hit-testing of board points
+
+Each point of a board is hit by a square of the token size centred on it. The
+grid cuts the bounding box of those squares into cells of half a token and
+stores in every cell the mask of points whose square overlaps it. A lookup
+reads one cell, keeps the candidate points it is asked about (e.g. the free
+ones, from an occupancy mask) and tests those squares exactly; on the boards
+in boards/ the squares do not overlap, so that is at most one test.
+
+The squares are half-open like sf::FloatRect::contains, so lookups return
+what scanning the points in index order would. Coordinates are board
+coordinates: the window view maps scaled window pixels onto them.
+*/
+
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include "Morris.hpp"
+
+struct SlotGrid {
+    float left = 0, top = 0; // Corner of the first cell
+    float cell = 25;         // Cell side
+    float size = 50;         // Side of a point's square
+    int cols = 0, rows = 0;
+    std::vector<uint32_t> cells; // Points overlapping each cell, row by row
+    std::vector<TopologyPoint> corners; // Top-left corner of each point's square
+
+    // Builds the grid for the points of 'topology', each hit by a size x size square
+    void build(const Topology& topology, float squareSize) {
+        size = squareSize;
+        cell = squareSize / 2;
+        corners.clear();
+        cells.clear();
+        cols = rows = 0;
+        if (topology.points.empty()) return;
+        float right = left = topology.points[0].x - size / 2;
+        float bottom = top = topology.points[0].y - size / 2;
+        for (const auto& p : topology.points) {
+            corners.push_back({p.x - size / 2, p.y - size / 2});
+            left = std::min(left, corners.back().x);
+            top = std::min(top, corners.back().y);
+            right = std::max(right, corners.back().x + size);
+            bottom = std::max(bottom, corners.back().y + size);
+        }
+        cols = static_cast<int>(std::floor((right - left) / cell)) + 1;
+        rows = static_cast<int>(std::floor((bottom - top) / cell)) + 1;
+        cells.assign(static_cast<size_t>(cols) * rows, 0);
+        for (size_t i = 0; i < corners.size(); ++i) {
+            int c0 = static_cast<int>(std::floor((corners[i].x - left) / cell));
+            int r0 = static_cast<int>(std::floor((corners[i].y - top) / cell));
+            int c1 = std::min(cols - 1, static_cast<int>(std::floor((corners[i].x + size - left) / cell)));
+            int r1 = std::min(rows - 1, static_cast<int>(std::floor((corners[i].y + size - top) / cell)));
+            for (int r = r0; r <= r1; ++r)
+                for (int c = c0; c <= c1; ++c) cells[static_cast<size_t>(r) * cols + c] |= 1u << i;
+        }
+    }
+
+    // Lowest of the 'candidates' points whose square contains (x, y), or -1
+    int pointAt(float x, float y, uint32_t candidates) const {
+        float fx = (x - left) / cell, fy = (y - top) / cell;
+        if (!(fx >= 0 && fy >= 0 && fx < cols && fy < rows)) return -1;
+        uint32_t hits = cells[static_cast<size_t>(fy) * cols + static_cast<size_t>(fx)] & candidates;
+        for (; hits; hits &= hits - 1) {
+            int i = lowestPoint(hits);
+            const TopologyPoint& c = corners[i];
+            if (x >= c.x && x < c.x + size && y >= c.y && y < c.y + size) return i;
+        }
+        return -1;
+    }
+};
@@ -0,0 +1,577 @@
+/*
+Tablebase - block-compressed perfect play tables with random access
+
+A tablebase packs every solved partition of a board (see Retrograde.hpp) into
+one file. Values are cut into fixed-size blocks that never span partitions,
+and each block is compressed on its own: runs of equal values become a value
+symbol followed by run-length symbols, and all symbols are Huffman coded with
+one code table per file. A block offset index lets a probe find and decode a
+single block, and a small LRU cache of decoded blocks sits in front of it.
+Every block carries a CRC-32 of its compressed bytes, so corruption is found
+without trusting the decoder (see tools/Verify.cpp).
+
+File layout (little-endian):
+  header      "MORRISTB", version, board name, points, men, symmetries,
+              block size, partition count, block count, Huffman code lengths
+  partitions  key (4 bytes), positions, first block
+  index       byte offset of every block in the data section, plus the end
+  checksums   CRC-32 of the compressed bytes of every block
+  data        compressed blocks, each starting on a byte boundary
+*/
+
+#pragma once
+
+#include <list>
+#include <array>
+#include <queue>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include "Retrograde.hpp"
+
+constexpr char kTablebaseMagic[8] = {'M', 'O', 'R', 'R', 'I', 'S', 'T', 'B'};
+constexpr uint32_t kTablebaseVersion = 3;
+
+// Symbols: 0-255 are values, kRunSymbol + k repeats the previous value
+// 2^k to 2^(k+1) - 1 more times, with k extra bits giving the exact count
+constexpr int kRunSymbol = 256;
+constexpr int kRunBuckets = 16;
+constexpr int kSymbols = kRunSymbol + kRunBuckets;
+constexpr int kMaxCodeLength = 12; // Keeps the decode table at 8 KB
+
+// CRC-32 (IEEE 802.3, reflected), one table lookup per byte
+inline uint32_t crc32(const uint8_t* data, std::size_t size) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    uint32_t c = 0xFFFFFFFFu;
+    for (std::size_t i = 0; i < size; ++i) c = table[(c ^ data[i]) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+// Writes bits most significant first
+class BitWriter {
+public:
+    void put(uint32_t bits, int count) {
+        for (int i = count - 1; i >= 0; --i) {
+            acc_ = (acc_ << 1) | ((bits >> i) & 1);
+            if (++used_ == 8) flushByte();
+        }
+    }
+    // Pads to a byte boundary
+    void align() {
+        while (used_) put(0, 1);
+    }
+    std::vector<uint8_t>& bytes() { return bytes_; }
+
+private:
+    void flushByte() {
+        bytes_.push_back(static_cast<uint8_t>(acc_));
+        acc_ = 0;
+        used_ = 0;
+    }
+    std::vector<uint8_t> bytes_;
+    uint32_t acc_ = 0;
+    int used_ = 0;
+};
+
+// Reads bits most significant first; reading past the end yields zeros
+class BitReader {
+public:
+    BitReader(const uint8_t* data, std::size_t size) : data_(data), end_(data + size) {}
+
+    uint32_t peek(int count) {
+        fill();
+        return static_cast<uint32_t>(buf_ >> (64 - count));
+    }
+    void skip(int count) {
+        buf_ <<= count;
+        bits_ -= count;
+    }
+    uint32_t get(int count) {
+        if (count == 0) return 0;
+        uint32_t v = peek(count);
+        skip(count);
+        return v;
+    }
+
+private:
+    void fill() {
+        if (bits_ > 56) return;
+        if (end_ - data_ >= 8) { // Refill whole bytes with one unaligned load
+            uint64_t word;
+            std::memcpy(&word, data_, 8);
+            buf_ |= __builtin_bswap64(word) >> bits_;
+            data_ += (63 - bits_) >> 3;
+            bits_ |= 56;
+            return;
+        }
+        while (bits_ <= 56) {
+            uint64_t byte = data_ < end_ ? *data_++ : 0;
+            buf_ |= byte << (56 - bits_);
+            bits_ += 8;
+        }
+    }
+    const uint8_t* data_;
+    const uint8_t* end_;
+    uint64_t buf_ = 0;
+    int bits_ = 0;
+};
+
+// Canonical Huffman code: lengths are stored in the file, codes are derived from them
+struct HuffmanCode {
+    std::array<uint8_t, kSymbols> lengths{};
+    std::array<uint16_t, kSymbols> codes{};
+    std::vector<uint16_t> decode; // Indexed by the next kMaxCodeLength bits: symbol << 4 | length
+
+    // Builds code lengths from symbol counts, limited to kMaxCodeLength bits
+    void build(const std::array<uint64_t, kSymbols>& counts) {
+        std::array<uint64_t, kSymbols> freq = counts;
+        for (;;) {
+            lengths.fill(0);
+            using Node = std::pair<uint64_t, int>;
+            std::priority_queue<Node, std::vector<Node>, std::greater<Node>> heap;
+            std::vector<int> parent;
+            for (int s = 0; s < kSymbols; ++s) {
+                if (!freq[s]) continue;
+                heap.push({freq[s], static_cast<int>(parent.size())});
+                parent.push_back(-1);
+            }
+            std::vector<int> leafNode(kSymbols, -1);
+            for (int s = 0, n = 0; s < kSymbols; ++s)
+                if (freq[s]) leafNode[s] = n++;
+            if (heap.size() == 1) { // A single symbol still needs a one-bit code
+                for (int s = 0; s < kSymbols; ++s)
+                    if (freq[s]) lengths[s] = 1;
+                break;
+            }
+            while (heap.size() > 1) {
+                Node a = heap.top(); heap.pop();
+                Node b = heap.top(); heap.pop();
+                int id = static_cast<int>(parent.size());
+                parent.push_back(-1);
+                parent[a.second] = parent[b.second] = id;
+                heap.push({a.first + b.first, id});
+            }
+            int longest = 0;
+            for (int s = 0; s < kSymbols; ++s) {
+                if (leafNode[s] < 0) continue;
+                int depth = 0;
+                for (int n = leafNode[s]; parent[n] >= 0; n = parent[n]) ++depth;
+                lengths[s] = static_cast<uint8_t>(depth);
+                longest = std::max(longest, depth);
+            }
+            if (longest <= kMaxCodeLength) break;
+            for (auto& f : freq) // Flatten the distribution and try again
+                if (f) f = (f + 1) / 2;
+        }
+        assign();
+    }
+
+    // Derives canonical codes and the decode table from the code lengths
+    bool assign() {
+        std::array<int, kMaxCodeLength + 1> perLength{};
+        for (uint8_t l : lengths) {
+            if (l > kMaxCodeLength) return false;
+            if (l) perLength[l]++;
+        }
+        std::array<uint32_t, kMaxCodeLength + 2> next{};
+        uint32_t code = 0;
+        for (int l = 1; l <= kMaxCodeLength; ++l) {
+            code = (code + perLength[l - 1]) << 1;
+            next[l] = code;
+        }
+        decode.assign(std::size_t(1) << kMaxCodeLength, 0);
+        for (int s = 0; s < kSymbols; ++s) {
+            int l = lengths[s];
+            if (!l) continue;
+            codes[s] = static_cast<uint16_t>(next[l]++);
+            if (codes[s] >> l) return false; // Over-subscribed lengths
+            uint32_t first = uint32_t(codes[s]) << (kMaxCodeLength - l);
+            for (uint32_t i = 0; i < (1u << (kMaxCodeLength - l)); ++i)
+                decode[first + i] = static_cast<uint16_t>(s << 4 | l);
+        }
+        return true;
+    }
+};
+
+// Splits values into value and run-length symbols, calling emit(symbol, extra bits, extra count)
+template <typename Emit>
+void tokenizeBlock(const uint8_t* values, std::size_t count, Emit&& emit) {
+    for (std::size_t i = 0; i < count;) {
+        std::size_t j = i + 1;
+        while (j < count && values[j] == values[i]) ++j;
+        emit(values[i], 0, 0);
+        for (uint64_t repeat = j - i - 1; repeat > 0;) {
+            int k = std::min(63 - __builtin_clzll(repeat), kRunBuckets - 1);
+            uint64_t take = std::min<uint64_t>(repeat, (uint64_t(2) << k) - 1);
+            emit(kRunSymbol + k, static_cast<uint32_t>(take - (uint64_t(1) << k)), k);
+            repeat -= take;
+        }
+        i = j;
+    }
+}
+
+// Decodes 'count' values of a block
+inline void decodeBlock(const HuffmanCode& code, const uint8_t* data, std::size_t size, uint8_t* out, std::size_t count) {
+    BitReader in(data, size);
+    std::size_t n = 0;
+    uint8_t last = 0;
+    while (n < count) {
+        uint16_t entry = code.decode[in.peek(kMaxCodeLength)];
+        in.skip(entry & 15);
+        int symbol = entry >> 4;
+        if (symbol < kRunSymbol) {
+            out[n++] = last = static_cast<uint8_t>(symbol);
+        } else {
+            int k = symbol - kRunSymbol;
+            std::size_t repeat = (std::size_t(1) << k) + in.get(k);
+            repeat = std::min(repeat, count - n);
+            std::memset(out + n, last, repeat);
+            n += repeat;
+        }
+    }
+}
+
+// Little-endian field helpers for the file header
+template <typename T>
+inline void putField(std::vector<uint8_t>& out, T v) {
+    for (std::size_t i = 0; i < sizeof(T); ++i) out.push_back(static_cast<uint8_t>(uint64_t(v) >> (8 * i)));
+}
+
+template <typename T>
+inline T getField(const uint8_t*& p) {
+    uint64_t v = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i) v |= uint64_t(p[i]) << (8 * i);
+    p += sizeof(T);
+    return static_cast<T>(v);
+}
+
+// A partition's entry in the tablebase
+struct TablebasePartition {
+    PartitionKey key;
+    uint64_t positions = 0;
+    uint64_t firstBlock = 0;
+};
+
+struct TablebaseStats {
+    uint64_t positions = 0;
+    uint64_t blocks = 0;
+    uint64_t compressedBytes = 0;
+};
+
+// Packs the solved partitions in 'store' into a tablebase file
+template <typename Mask>
+bool writeTablebase(const std::string& path, const std::string& boardName, const Rules<Mask>& rules,
+                    const PositionIndexer<Mask>& indexer, TableStore<Mask>& store, const std::vector<PartitionKey>& keys, uint32_t blockSize,
+                    std::string& error, TablebaseStats& stats) {
+    std::vector<TablebasePartition> parts;
+    uint64_t blocks = 0;
+    for (const auto& key : keys) {
+        if (!store.values(key)) {
+            error = "partition " + key.name() + " has not been solved";
+            return false;
+        }
+        TablebasePartition p{key, indexer.size(key), blocks};
+        blocks += (p.positions + blockSize - 1) / blockSize;
+        parts.push_back(p);
+    }
+
+    // One pass to count symbols for the shared code, one to encode
+    std::array<uint64_t, kSymbols> counts{};
+    for (const auto& p : parts) {
+        const uint8_t* v = store.values(p.key);
+        for (uint64_t b = 0; b < p.positions; b += blockSize)
+            tokenizeBlock(v + b, std::min<uint64_t>(blockSize, p.positions - b),
+                          [&](int symbol, uint32_t, int) { counts[symbol]++; });
+    }
+    counts[0] |= parts.empty() ? 1 : 0;
+    HuffmanCode code;
+    code.build(counts);
+
+    std::vector<uint64_t> offsets;
+    BitWriter data;
+    for (const auto& p : parts) {
+        const uint8_t* v = store.values(p.key);
+        for (uint64_t b = 0; b < p.positions; b += blockSize) {
+            offsets.push_back(data.bytes().size());
+            tokenizeBlock(v + b, std::min<uint64_t>(blockSize, p.positions - b), [&](int symbol, uint32_t extra, int bits) {
+                data.put(code.codes[symbol], code.lengths[symbol]);
+                data.put(extra, bits);
+            });
+            data.align();
+        }
+    }
+    offsets.push_back(data.bytes().size());
+
+    std::vector<uint8_t> head(kTablebaseMagic, kTablebaseMagic + 8);
+    putField<uint32_t>(head, kTablebaseVersion);
+    putField<uint32_t>(head, static_cast<uint32_t>(boardName.size()));
+    head.insert(head.end(), boardName.begin(), boardName.end());
+    putField<uint32_t>(head, static_cast<uint32_t>(rules.points));
+    putField<uint32_t>(head, static_cast<uint32_t>(rules.men));
+    putField<uint32_t>(head, static_cast<uint32_t>(indexer.symmetries()));
+    putField<uint32_t>(head, blockSize);
+    putField<uint32_t>(head, static_cast<uint32_t>(parts.size()));
+    putField<uint64_t>(head, blocks);
+    head.insert(head.end(), code.lengths.begin(), code.lengths.end());
+    for (const auto& p : parts) {
+        for (int c : {p.key.stmMen, p.key.stmHand, p.key.oppMen, p.key.oppHand}) putField<uint8_t>(head, static_cast<uint8_t>(c));
+        putField<uint64_t>(head, p.positions);
+        putField<uint64_t>(head, p.firstBlock);
+    }
+    for (uint64_t o : offsets) putField<uint64_t>(head, o);
+    for (uint64_t b = 0; b < blocks; ++b)
+        putField<uint32_t>(head, crc32(data.bytes().data() + offsets[b], offsets[b + 1] - offsets[b]));
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(head.data()), static_cast<std::streamsize>(head.size()));
+    out.write(reinterpret_cast<const char*>(data.bytes().data()), static_cast<std::streamsize>(data.bytes().size()));
+    if (!out) {
+        error = "cannot write " + path;
+        return false;
+    }
+    stats.blocks = blocks;
+    stats.compressedBytes = head.size() + data.bytes().size();
+    stats.positions = 0;
+    for (const auto& p : parts) stats.positions += p.positions;
+    return true;
+}
+
+// A tablebase file mapped read-only. Safe to share between threads; pair it with
+// one BlockCache per thread for probing.
+class TablebaseFile {
+public:
+    ~TablebaseFile() { file_.close(); }
+
+    bool open(const std::string& path, std::string& error) {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0 || !file_.open(path, static_cast<uint64_t>(st.st_size), false)) {
+            error = "cannot open " + path;
+            return false;
+        }
+        const uint8_t* p = file_.data;
+        const uint8_t* end = p + file_.size;
+        auto need = [&](uint64_t bytes) { return static_cast<uint64_t>(end - p) >= bytes; };
+        if (!need(8 + 4 + 4) || std::memcmp(p, kTablebaseMagic, 8) != 0) {
+            error = path + " is not a tablebase";
+            return false;
+        }
+        p += 8;
+        if (getField<uint32_t>(p) != kTablebaseVersion) {
+            error = path + " has an unsupported version";
+            return false;
+        }
+        uint32_t nameLength = getField<uint32_t>(p);
+        if (!need(nameLength + 28 + kSymbols)) return corrupt(path, error);
+        name_.assign(reinterpret_cast<const char*>(p), nameLength);
+        p += nameLength;
+        points_ = getField<uint32_t>(p);
+        men_ = getField<uint32_t>(p);
+        symmetries_ = getField<uint32_t>(p);
+        blockSize_ = getField<uint32_t>(p);
+        uint32_t partCount = getField<uint32_t>(p);
+        blockCount_ = getField<uint64_t>(p);
+        std::copy(p, p + kSymbols, code_.lengths.begin());
+        p += kSymbols;
+        if (!code_.assign() || blockSize_ == 0 || men_ > 63 || blockCount_ > file_.size) return corrupt(path, error);
+
+        if (!need(uint64_t(partCount) * 20 + (blockCount_ + 1) * 8 + blockCount_ * 4)) return corrupt(path, error);
+        dim_ = men_ + 1;
+        lookup_.assign(std::size_t(dim_) * dim_ * dim_ * dim_, -1);
+        // Partitions tile the blocks in file order, as writeTablebase() lays them out, so
+        // every block has exactly one owner and no probe reaches past the last block
+        parts_.clear();
+        uint64_t nextBlock = 0;
+        for (uint32_t i = 0; i < partCount; ++i) {
+            TablebasePartition part;
+            part.key.stmMen = getField<uint8_t>(p);
+            part.key.stmHand = getField<uint8_t>(p);
+            part.key.oppMen = getField<uint8_t>(p);
+            part.key.oppHand = getField<uint8_t>(p);
+            part.positions = getField<uint64_t>(p);
+            part.firstBlock = getField<uint64_t>(p);
+            uint64_t blocks = part.positions / blockSize_ + (part.positions % blockSize_ != 0);
+            if (!inRange(part.key) || lookup_[slot(part.key)] >= 0 || part.firstBlock != nextBlock ||
+                blocks > blockCount_ - nextBlock)
+                return corrupt(path, error);
+            nextBlock += blocks;
+            lookup_[slot(part.key)] = static_cast<int>(parts_.size());
+            parts_.push_back(part);
+        }
+        if (nextBlock != blockCount_) return corrupt(path, error);
+        index_ = p;
+        crcs_ = p + (blockCount_ + 1) * 8;
+        data_ = crcs_ + blockCount_ * 4;
+        // Block offsets start at 0, never decrease and end within the file
+        if (blockOffset(0) != 0) return corrupt(path, error);
+        for (uint64_t b = 0; b < blockCount_; ++b)
+            if (blockOffset(b + 1) < blockOffset(b)) return corrupt(path, error);
+        if (blockOffset(blockCount_) > static_cast<uint64_t>(end - data_)) return corrupt(path, error);
+        return true;
+    }
+
+    const std::string& name() const { return name_; }
+    int points() const { return static_cast<int>(points_); }
+    int men() const { return static_cast<int>(men_); }
+    int symmetries() const { return static_cast<int>(symmetries_); } // Indices need a PositionIndexer with as many
+    uint32_t blockSize() const { return blockSize_; }
+    uint64_t blockCount() const { return blockCount_; }
+    uint64_t fileSize() const { return file_.size; }
+    const std::vector<TablebasePartition>& partitions() const { return parts_; }
+    const HuffmanCode& code() const { return code_; }
+
+    // The partition entry for a key, or nullptr if the tablebase does not hold it
+    const TablebasePartition* find(const PartitionKey& key) const {
+        if (!inRange(key)) return nullptr;
+        int i = lookup_[slot(key)];
+        return i < 0 ? nullptr : &parts_[i];
+    }
+
+    uint64_t blockOffset(uint64_t block) const {
+        const uint8_t* p = index_ + block * 8;
+        return getField<uint64_t>(p);
+    }
+
+    // Number of values in a block (the last block of a partition may be short)
+    uint32_t blockValues(const TablebasePartition& part, uint64_t block) const {
+        uint64_t start = (block - part.firstBlock) * blockSize_;
+        return static_cast<uint32_t>(std::min<uint64_t>(blockSize_, part.positions - start));
+    }
+
+    // True if the compressed bytes of a block match their checksum
+    bool blockIntact(uint64_t block) const {
+        const uint8_t* p = crcs_ + block * 4;
+        uint64_t begin = blockOffset(block), end = blockOffset(block + 1);
+        return end >= begin && end <= blockOffset(blockCount_) && getField<uint32_t>(p) == crc32(data_ + begin, end - begin);
+    }
+
+    // Software prefetches for probes that know their blocks ahead: first the block's entry
+    // in the offset index, then, once that has arrived, its first compressed bytes
+    void prefetchIndex(uint64_t block) const { __builtin_prefetch(index_ + block * 8); }
+    void prefetchData(uint64_t block) const {
+        const uint8_t* p = data_ + blockOffset(block);
+        for (int line = 0; line < 4; ++line) __builtin_prefetch(p + 64 * line);
+    }
+
+    // Decodes the first 'count' values of a block (a prefix is cheaper than the whole)
+    void decode(uint64_t block, uint32_t count, uint8_t* out) const {
+        uint64_t begin = blockOffset(block), end = blockOffset(block + 1);
+        decodeBlock(code_, data_ + begin, end - begin, out, count);
+    }
+
+private:
+    bool corrupt(const std::string& path, std::string& error) {
+        error = path + " is truncated or corrupt";
+        return false;
+    }
+    bool inRange(const PartitionKey& k) const {
+        return k.stmMen >= 0 && k.stmHand >= 0 && k.oppMen >= 0 && k.oppHand >= 0 &&
+               k.stmMen < dim_ && k.stmHand < dim_ && k.oppMen < dim_ && k.oppHand < dim_;
+    }
+    std::size_t slot(const PartitionKey& k) const {
+        return ((std::size_t(k.stmMen) * dim_ + k.stmHand) * dim_ + k.oppMen) * dim_ + k.oppHand;
+    }
+
+    MappedFile file_;
+    std::string name_;
+    uint32_t points_ = 0, men_ = 0, symmetries_ = 0, blockSize_ = 0;
+    int dim_ = 0;
+    uint64_t blockCount_ = 0;
+    HuffmanCode code_;
+    std::vector<TablebasePartition> parts_;
+    std::vector<int> lookup_; // Partition index by key
+    const uint8_t* index_ = nullptr;
+    const uint8_t* crcs_ = nullptr;
+    const uint8_t* data_ = nullptr;
+};
+
+// Block number -> partition, for tools that take blocks in file order. Fails on a block
+// past the last one, a block two partitions claim, or a block no partition owns.
+inline bool blockOwners(const TablebaseFile& tb, std::vector<const TablebasePartition*>& owner, std::string& error) {
+    owner.assign(tb.blockCount(), nullptr);
+    for (const auto& part : tb.partitions())
+        for (uint64_t b = 0; b * tb.blockSize() < part.positions; ++b) {
+            uint64_t block = part.firstBlock + b;
+            if (block >= tb.blockCount() || owner[block]) {
+                error = "partition " + part.key.name() + " claims block " + std::to_string(block) +
+                        (block >= tb.blockCount() ? ", past the last block" : ", which " + owner[block]->key.name() + " holds");
+                return false;
+            }
+            owner[block] = &part;
+        }
+    for (uint64_t b = 0; b < tb.blockCount(); ++b)
+        if (!owner[b]) {
+            error = "block " + std::to_string(b) + " belongs to no partition";
+            return false;
+        }
+    return true;
+}
+
+// Least recently used cache of decoded blocks
+class BlockCache {
+public:
+    explicit BlockCache(std::size_t capacity) : capacity_(std::max<std::size_t>(1, capacity)) {}
+
+    // Decoded values of 'block', decoding it on a miss
+    const uint8_t* get(const TablebaseFile& tb, const TablebasePartition& part, uint64_t block) {
+        auto it = map_.find(block);
+        if (it != map_.end()) {
+            ++hits_;
+            order_.splice(order_.begin(), order_, it->second);
+            return it->second->values.data();
+        }
+        ++misses_;
+        if (map_.size() == capacity_) {
+            map_.erase(order_.back().block);
+            order_.splice(order_.begin(), order_, std::prev(order_.end()));
+        } else {
+            order_.emplace_front();
+        }
+        Entry& e = order_.front();
+        e.block = block;
+        e.values.resize(tb.blockSize());
+        tb.decode(block, tb.blockValues(part, block), e.values.data());
+        map_[block] = order_.begin();
+        return e.values.data();
+    }
+
+    uint64_t hits() const { return hits_; }
+    uint64_t misses() const { return misses_; }
+
+private:
+    struct Entry {
+        uint64_t block = 0;
+        std::vector<uint8_t> values;
+    };
+    std::size_t capacity_;
+    std::list<Entry> order_; // Most recently used first
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> map_;
+    uint64_t hits_ = 0, misses_ = 0;
+};
+
+// Value of a position: decodes at most one block. Partitions below the minimum
+// token count have no file (see unstoredValue()); positions the tablebase does not
+// cover are kUnknown.
+template <typename Mask>
+uint8_t probeTablebase(const TablebaseFile& tb, BlockCache& cache, const Rules<Mask>& rules,
+                       const PositionIndexer<Mask>& indexer, const Position<Mask>& pos) {
+    PartitionKey key = partitionOf(pos);
+    if (!isStored(rules, key)) return unstoredValue(rules, key);
+    const TablebasePartition* part = tb.find(key);
+    if (!part) return kUnknown;
+    int me = static_cast<int>(pos.turn);
+    uint64_t index = indexer.index(key, pos.men[me], pos.men[1 - me]);
+    if (index >= part->positions) return kUnknown; // A tablebase built with another indexer
+    uint64_t block = part->firstBlock + index / tb.blockSize();
+    return cache.get(tb, *part, block)[index % tb.blockSize()];
+}
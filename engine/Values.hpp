@@ -0,0 +1,42 @@
+/*
+Values - how the solvers and tables encode the value of a position
+
+One byte per position, for the side to move: the distance in plies to the end
+of the game with perfect play, or kDraw. Kept apart from Retrograde.hpp so that
+code reading values (the compile-time table, searches, the game) does not pull
+in the solver and its memory-mapped files.
+*/
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+// Value of a position for the side to move. Distances are in plies to the end of
+// the game with perfect play: odd distances are wins, even distances are losses
+// (0 = the side to move has already lost).
+constexpr uint8_t kDraw = 255;
+constexpr uint8_t kUnknown = 254;   // Only while solving
+constexpr uint8_t kMaxDistance = 253;
+
+constexpr bool isWinValue(uint8_t v) { return v < kUnknown && (v & 1); }
+constexpr bool isLossValue(uint8_t v) { return v < kUnknown && !(v & 1); }
+
+// Readable form of a value, e.g. "win in 7"
+inline std::string valueName(uint8_t v) {
+    if (v == kDraw) return "draw";
+    if (v == kUnknown) return "unknown";
+    if (v > kMaxDistance) return "invalid (" + std::to_string(v) + ")";
+    return std::string(isWinValue(v) ? "win" : "loss") + " in " + std::to_string(v);
+}
+
+// Value of a position from the value of the position a move leads to (the opponent's)
+constexpr uint8_t parentValue(uint8_t child) {
+    return child >= kUnknown ? child : static_cast<uint8_t>(child + 1);
+}
+
+// Orders values from the side to move's point of view: higher is better. Wins rank by
+// speed, then draws, then unknown values, then losses by how long they hold out.
+constexpr int valueRank(uint8_t v) {
+    return isWinValue(v) ? 1000 - v : v == kDraw ? 0 : v == kUnknown ? -1 : -1000 + v;
+}
@@ -0,0 +1,289 @@
+/*
+MorrisLib - the C interface of MorrisLib.h over the header-only engine
+
+Build: g++ -std=c++17 -O2 -pthread -shared -fPIC -fvisibility=hidden lib/MorrisLib.cpp -o libmorris.so
+
+Every entry point checks its pointers and positions before the engine sees
+them, since the engine itself trusts its callers. No exception may unwind
+into a C caller: every entry point that can throw (all but the accessors
+that read a field) runs its body inside guarded() or a try block of its own,
+and an exception becomes MORRIS_ERROR_RESOURCE.
+*/
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include "MorrisLib.h"
+#include "../engine/Analysis.hpp"
+#include "../engine/BatchProbe.hpp"
+
+static_assert(MORRIS_MAX_MOVES == kMaxMoves && MORRIS_VALUE_DRAW == kDraw && MORRIS_VALUE_UNKNOWN == kUnknown &&
+                  MORRIS_WDL_UNKNOWN == kWdlUnknown,
+              "constants");
+
+struct morris_engine {
+    Topology topology;
+    Rules32 rules;
+    std::string error;
+    std::unique_ptr<TablebaseFile> tablebase;
+    std::unique_ptr<PositionIndexer<uint32_t>> indexer;
+    std::unique_ptr<BlockCache> cache;
+    std::unique_ptr<Searcher<uint32_t>> searcher;
+    std::atomic<bool> stop{false};
+
+    int fail(int code, std::string message) {
+        error = std::move(message);
+        return code;
+    }
+};
+
+namespace {
+
+// Copied field by field rather than cast, since the caller's struct is not a Position32
+Position32 position(const morris_position& pos) {
+    Position32 p;
+    p.men = {pos.men[0], pos.men[1]};
+    p.hand = {pos.hand[0], pos.hand[1]};
+    p.turn = static_cast<Player>(pos.turn);
+    return p;
+}
+
+Move engineMove(const morris_move& m) { return {m.from, m.to, m.remove}; }
+morris_move libraryMove(const Move& m) { return {m.from, m.to, m.remove}; }
+
+void writeError(const char* message, char* out, std::size_t size) {
+    if (!out || size == 0) return;
+    std::size_t n = std::min(std::strlen(message), size - 1);
+    std::memcpy(out, message, n);
+    out[n] = '\0';
+}
+
+// A position the board allows: tokens on its points, on separate points, and no more than its
+// men, in a game that is not over before it (isPastGameEnd())
+bool isPosition(const Rules32& rules, const morris_position& pos) {
+    if ((pos.men[0] & pos.men[1]) || ((pos.men[0] | pos.men[1]) & ~rules.full) || (pos.turn != 0 && pos.turn != 1))
+        return false;
+    for (int p = 0; p < 2; ++p)
+        if (pos.hand[p] < 0 || pos.hand[p] > rules.men || countMen(pos.men[p]) + pos.hand[p] > rules.men) return false;
+    return !isPastGameEnd(rules, position(pos));
+}
+
+int fault(morris_engine* engine, const char* what) noexcept {
+    if (engine) {
+        try {
+            engine->error = what;
+        } catch (...) {
+            engine->error.clear();
+        }
+    }
+    return MORRIS_ERROR_RESOURCE;
+}
+
+// Runs an entry point's body, turning an exception into MORRIS_ERROR_RESOURCE
+template <typename Body>
+int guarded(morris_engine* engine, Body&& body) noexcept {
+    try {
+        return body();
+    } catch (const std::exception& e) {
+        return fault(engine, e.what());
+    } catch (...) {
+        return fault(engine, "unexpected failure in the engine");
+    }
+}
+
+// Checks the engine and a position; an engine-less call has nowhere to report to
+int checkPosition(morris_engine* engine, const morris_position* pos) {
+    if (!engine) return MORRIS_ERROR_ARGUMENT;
+    if (!pos) return engine->fail(MORRIS_ERROR_ARGUMENT, "no position");
+    if (!isPosition(engine->rules, *pos)) return engine->fail(MORRIS_ERROR_POSITION, "not a position a game of " + engine->topology.name + " reaches");
+    return MORRIS_OK;
+}
+
+// Reads a board; 'open' makes its stream
+template <typename Open>
+morris_engine* create(Open&& open, const char* source, char* error, std::size_t errorSize) noexcept {
+    try {
+        auto in = open();
+        auto engine = std::make_unique<morris_engine>();
+        std::string message;
+        if (!*in) message = std::string("cannot open ") + source;
+        else if (parseTopology(*in, engine->topology, message) && compileTopology(engine->topology, engine->rules, message))
+            return engine.release();
+        writeError(message.c_str(), error, errorSize);
+    } catch (const std::exception& e) {
+        writeError(e.what(), error, errorSize);
+    } catch (...) {
+        writeError("unexpected failure in the engine", error, errorSize);
+    }
+    return nullptr;
+}
+
+} // namespace
+
+extern "C" {
+
+int morris_api_version(void) { return MORRIS_API_VERSION; }
+
+morris_engine* morris_create(const char* board_path, char* error, size_t error_size) {
+    if (!board_path) {
+        writeError("no board path", error, error_size);
+        return nullptr;
+    }
+    return create([&] { return std::make_unique<std::ifstream>(board_path); }, board_path, error, error_size);
+}
+
+morris_engine* morris_create_from_text(const char* board_text, char* error, size_t error_size) {
+    if (!board_text) {
+        writeError("no board text", error, error_size);
+        return nullptr;
+    }
+    return create([&] { return std::make_unique<std::istringstream>(board_text); }, "board text", error, error_size);
+}
+
+void morris_destroy(morris_engine* engine) { delete engine; }
+
+const char* morris_error(const morris_engine* engine) { return engine ? engine->error.c_str() : "no engine"; }
+
+const char* morris_board_name(const morris_engine* engine) { return engine ? engine->topology.name.c_str() : ""; }
+
+int morris_points(const morris_engine* engine) { return engine ? engine->rules.points : 0; }
+
+int morris_men(const morris_engine* engine) { return engine ? engine->rules.men : 0; }
+
+void morris_start_position(const morris_engine* engine, morris_position* out) {
+    if (!engine || !out) return;
+    guarded(nullptr, [&] {
+        Position32 start = startPosition(engine->rules);
+        *out = {{start.men[0], start.men[1]}, {start.hand[0], start.hand[1]}, static_cast<int32_t>(start.turn)};
+        return MORRIS_OK;
+    });
+}
+
+int morris_list_moves(morris_engine* engine, const morris_position* pos, morris_move* out, int capacity) {
+    return guarded(engine, [&] {
+        if (int status = checkPosition(engine, pos)) return status;
+        if (capacity > 0 && !out) return engine->fail(MORRIS_ERROR_ARGUMENT, "no move buffer");
+        Position32 p = position(*pos);
+        Move moves[kMaxMoves];
+        int n = isLost(engine->rules, p) ? 0 : generateMoves(engine->rules, p, moves);
+        for (int i = 0; i < std::min(n, capacity); ++i) out[i] = libraryMove(moves[i]);
+        return n;
+    });
+}
+
+int morris_apply_move(morris_engine* engine, morris_position* pos, morris_move move) {
+    return guarded(engine, [&] {
+        if (int status = checkPosition(engine, pos)) return status;
+        Position32 p = position(*pos);
+        Move moves[kMaxMoves];
+        int n = isLost(engine->rules, p) ? 0 : generateMoves(engine->rules, p, moves);
+        if (std::find(moves, moves + n, engineMove(move)) == moves + n)
+            return engine->fail(MORRIS_ERROR_MOVE, moveName(engineMove(move)) + " is not a legal move");
+        Position32 next = applyMove(p, engineMove(move));
+        *pos = {{next.men[0], next.men[1]}, {next.hand[0], next.hand[1]}, static_cast<int32_t>(next.turn)};
+        return MORRIS_OK;
+    });
+}
+
+int morris_is_game_over(morris_engine* engine, const morris_position* pos) {
+    return guarded(engine, [&] {
+        if (int status = checkPosition(engine, pos)) return status;
+        return isGameOver(engine->rules, position(*pos)) ? 1 : 0;
+    });
+}
+
+int morris_move_name(morris_move move, char* out, size_t size) {
+    if (!out || size == 0) return MORRIS_ERROR_ARGUMENT;
+    return guarded(nullptr, [&] {
+        writeError(moveName(engineMove(move)).c_str(), out, size);
+        return MORRIS_OK;
+    });
+}
+
+int morris_parse_move(const char* text, morris_move* out) {
+    if (!text || !out) return MORRIS_ERROR_ARGUMENT;
+    return guarded(nullptr, [&] {
+        Move m;
+        if (!parseMove(text, m)) return MORRIS_ERROR_ARGUMENT;
+        *out = libraryMove(m);
+        return MORRIS_OK;
+    });
+}
+
+int morris_open_tablebase(morris_engine* engine, const char* path, size_t cache_blocks) {
+    if (!engine) return MORRIS_ERROR_ARGUMENT;
+    return guarded(engine, [&] {
+        if (!path) return engine->fail(MORRIS_ERROR_ARGUMENT, "no tablebase path");
+        auto tb = std::make_unique<TablebaseFile>();
+        if (!tb->open(path, engine->error)) return MORRIS_ERROR_TABLEBASE;
+        if (!engine->indexer) engine->indexer = std::make_unique<PositionIndexer<uint32_t>>(engine->rules);
+        if (tb->points() != engine->rules.points || tb->men() != engine->rules.men || tb->symmetries() != engine->indexer->symmetries())
+            return engine->fail(MORRIS_ERROR_TABLEBASE, std::string(path) + " was not built for " + engine->topology.name);
+        auto cache = std::make_unique<BlockCache>(cache_blocks);
+        engine->tablebase = std::move(tb);
+        engine->cache = std::move(cache);
+        return MORRIS_OK;
+    });
+}
+
+int morris_probe(morris_engine* engine, const morris_position* pos, int8_t* wdl, uint8_t* value) {
+    return guarded(engine, [&] {
+        if (int status = checkPosition(engine, pos)) return status;
+        if (!engine->tablebase) return engine->fail(MORRIS_ERROR_TABLEBASE, "no tablebase is open");
+        uint8_t v = probeTablebase(*engine->tablebase, *engine->cache, engine->rules, *engine->indexer, position(*pos));
+        if (wdl) *wdl = wdlOf(v);
+        if (value) *value = v;
+        return MORRIS_OK;
+    });
+}
+
+int morris_probe_batch(morris_engine* engine, const morris_position* positions, size_t count, int8_t* wdl,
+                       uint8_t* value, int threads) {
+    if (!engine) return MORRIS_ERROR_ARGUMENT;
+    return guarded(engine, [&] {
+        if (count == 0) return MORRIS_OK;
+        if (!positions) return engine->fail(MORRIS_ERROR_ARGUMENT, "no positions");
+        if (count > UINT32_MAX) return engine->fail(MORRIS_ERROR_ARGUMENT, "a batch holds fewer than 2^32 positions");
+        if (!engine->tablebase) return engine->fail(MORRIS_ERROR_TABLEBASE, "no tablebase is open");
+        std::vector<Position32> batch(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            if (!isPosition(engine->rules, positions[i]))
+                return engine->fail(MORRIS_ERROR_POSITION, "position " + std::to_string(i) + " is not a position a game of " +
+                                                               engine->topology.name + " reaches");
+            batch[i] = position(positions[i]);
+        }
+        probeBatch(*engine->tablebase, engine->rules, *engine->indexer, batch.data(), count, wdl, value, threads);
+        return MORRIS_OK;
+    });
+}
+
+int morris_search(morris_engine* engine, const morris_position* pos, const morris_search_limits* limits,
+                  morris_search_result* out) {
+    return guarded(engine, [&] {
+        if (int status = checkPosition(engine, pos)) return status;
+        if (!limits || !out) return engine->fail(MORRIS_ERROR_ARGUMENT, "no limits or no result");
+        if (limits->depth < 0 || !(limits->seconds >= 0)) return engine->fail(MORRIS_ERROR_ARGUMENT, "negative limits");
+        if (!engine->searcher) engine->searcher = std::make_unique<Searcher<uint32_t>>(engine->rules);
+        SearchLimits l;
+        if (limits->depth > 0) l.depth = limits->depth;
+        l.seconds = limits->seconds;
+        l.stop = &engine->stop;
+        SearchResult r = engine->searcher->search(position(*pos), l);
+        // Cleared after the search rather than before, so that a stop sent just before it
+        // starts still ends it
+        engine->stop = false;
+        out->best = libraryMove(r.best);
+        out->score = r.score;
+        out->depth = r.depth;
+        out->value = searchValue(r);
+        out->nodes = r.nodes;
+        out->seconds = r.seconds;
+        return MORRIS_OK;
+    });
+}
+
+void morris_stop(morris_engine* engine) {
+    if (engine) engine->stop = true;
+}
+
+} // extern "C"
@@ -0,0 +1,136 @@
+/*
+MorrisLib - C interface to the headless engine, for embedding it in other programs
+
+Build: g++ -std=c++17 -O2 -pthread -shared -fPIC -fvisibility=hidden lib/MorrisLib.cpp -o libmorris.so
+
+A morris_engine holds one board's rules, optionally its tablebase, and a
+searcher. Positions and moves are plain structs owned by the caller, which
+the library copies rather than keeps, and every output goes to a buffer the
+caller passes in; the library frees nothing the caller did not get from
+morris_create(). Functions that can fail return MORRIS_OK or a negative
+MORRIS_ERROR_* code, and morris_error() says what went wrong.
+
+An engine is used by one thread at a time, except morris_stop(), which any
+thread may call to end the search that is running, or else the next one.
+Separate engines are independent: one per thread searches or probes in
+parallel.
+
+Positions use the game's layout: bit i of men[p] is point i for player p
+(0 is Player A, 1 is Player B), hand[p] counts tokens player p has yet to
+place, and turn is the player to move. Values are those of engine/Values.hpp:
+for the side to move, odd is a win and even a loss in that many plies, 255 a
+draw and 254 unknown. Boards have up to 32 points.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MORRIS_API __attribute__((visibility("default")))
+
+#define MORRIS_API_VERSION 1
+#define MORRIS_MAX_MOVES 1024 /* Legal moves of any position, each removal choice counted */
+
+#define MORRIS_OK 0
+#define MORRIS_ERROR_ARGUMENT -1  /* A null pointer, a bad option, or a board that does not load */
+#define MORRIS_ERROR_POSITION -2  /* Not a position of the board, or one after the game ended */
+#define MORRIS_ERROR_MOVE -3      /* Not a legal move of the position */
+#define MORRIS_ERROR_TABLEBASE -4 /* No tablebase, or one that does not open or fit the board */
+#define MORRIS_ERROR_RESOURCE -5  /* Out of memory, or another failure inside the engine */
+
+#define MORRIS_VALUE_DRAW 255
+#define MORRIS_VALUE_UNKNOWN 254
+
+#define MORRIS_WDL_WIN 1
+#define MORRIS_WDL_DRAW 0
+#define MORRIS_WDL_LOSS -1
+#define MORRIS_WDL_UNKNOWN 2
+
+typedef struct morris_engine morris_engine;
+
+typedef struct morris_position {
+    uint32_t men[2];
+    int32_t hand[2];
+    int32_t turn;
+} morris_position;
+
+/* Places on 'to' if from is -1, else slides or flies from 'from'; remove is -1 or the
+   opponent token taken by a mill */
+typedef struct morris_move {
+    int8_t from;
+    int8_t to;
+    int8_t remove;
+} morris_move;
+
+typedef struct morris_search_limits {
+    int32_t depth;  /* Plies, 0 for the deepest the searcher goes */
+    double seconds; /* 0 for no time limit */
+} morris_search_limits;
+
+typedef struct morris_search_result {
+    morris_move best; /* to is -1 if the side to move has no move */
+    int32_t score;    /* For the side to move: material, or a forced result (see value) */
+    int32_t depth;    /* Last depth searched to the end */
+    uint8_t value;    /* The value a forced result proves, else MORRIS_VALUE_UNKNOWN */
+    uint64_t nodes;
+    double seconds;
+} morris_search_result;
+
+MORRIS_API int morris_api_version(void);
+
+/* An engine for a board description (see boards/), from a file or from its text. On
+   failure returns NULL and writes a message to 'error' (which may be NULL). */
+MORRIS_API morris_engine* morris_create(const char* board_path, char* error, size_t error_size);
+MORRIS_API morris_engine* morris_create_from_text(const char* board_text, char* error, size_t error_size);
+MORRIS_API void morris_destroy(morris_engine* engine);
+
+/* The last failure's message; valid until the next call on the engine */
+MORRIS_API const char* morris_error(const morris_engine* engine);
+
+MORRIS_API const char* morris_board_name(const morris_engine* engine);
+MORRIS_API int morris_points(const morris_engine* engine);
+MORRIS_API int morris_men(const morris_engine* engine);
+
+MORRIS_API void morris_start_position(const morris_engine* engine, morris_position* out);
+
+/* Writes up to 'capacity' legal moves and returns how many there are, or an error.
+   A position where the side to move has lost has none. */
+MORRIS_API int morris_list_moves(morris_engine* engine, const morris_position* pos, morris_move* out, int capacity);
+
+/* Plays a legal move on *pos */
+MORRIS_API int morris_apply_move(morris_engine* engine, morris_position* pos, morris_move move);
+
+/* 1 if the side to move has lost (or the game is otherwise over), 0 if not, or an error */
+MORRIS_API int morris_is_game_over(morris_engine* engine, const morris_position* pos);
+
+/* "4" places on point 4, "3-4" moves from 3 to 4, "3-4x7" also removes the token on 7,
+   "none" is no move. morris_move_name() writes at most 'size' bytes, terminated. */
+MORRIS_API int morris_move_name(morris_move move, char* out, size_t size);
+MORRIS_API int morris_parse_move(const char* text, morris_move* out);
+
+/* Opens a tablebase built for the engine's board (tools/Solve, tools/Pack), replacing any
+   open one; 'cache_blocks' decoded blocks are kept for morris_probe() */
+MORRIS_API int morris_open_tablebase(morris_engine* engine, const char* path, size_t cache_blocks);
+
+/* The value of a position, and its WDL verdict; either output may be NULL */
+MORRIS_API int morris_probe(morris_engine* engine, const morris_position* pos, int8_t* wdl, uint8_t* value);
+
+/* The values of 'count' positions at once (engine/BatchProbe.hpp), on up to 'threads'
+   threads; either output array may be NULL */
+MORRIS_API int morris_probe_batch(morris_engine* engine, const morris_position* positions, size_t count,
+                                  int8_t* wdl, uint8_t* value, int threads);
+
+/* Searches a position (engine/Search.hpp) within the limits, or until morris_stop() */
+MORRIS_API int morris_search(morris_engine* engine, const morris_position* pos, const morris_search_limits* limits,
+                             morris_search_result* out);
+/* Ends the search that is running; if none is, the next one returns at once */
+MORRIS_API void morris_stop(morris_engine* engine);
+
+#ifdef __cplusplus
+}
+#endif
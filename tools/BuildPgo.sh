@@ -0,0 +1,43 @@
+#!/bin/sh
+# BuildPgo - builds the game with profile-guided and link-time optimisation
+#
+# Usage: tools/BuildPgo.sh [output] [recording.rec ...]   (default output: ThreeMensMorris-pgo)
+# Run from the repository root. CXX, CXXFLAGS (e.g. -I<SFML>/include) and LIBS
+# (default: -lsfml-graphics -lsfml-window -lsfml-system; add icon.res -mwindows
+# on Windows) can be set in the environment.
+#
+#  1. builds an instrumented game (-fprofile-generate) in pgo/;
+#  2. trains it headless: self-play on every board in boards/ and playback of
+#     the given recordings (ThreeMensMorris --record), the workload the game
+#     runs in play;
+#  3. rebuilds it with -fprofile-use -flto. Headless runs never draw, so
+#     -fprofile-partial-training keeps the code the training did not reach
+#     optimised as in a plain -O2 build instead of for size.
+# The game is compiled separately from the link, so that both builds name the
+# object, and so the profile, the same.
+
+set -e
+CXX=${CXX:-g++}
+LIBS=${LIBS--lsfml-graphics -lsfml-window -lsfml-system}
+OUT=${1:-ThreeMensMorris-pgo}
+[ $# -gt 0 ] && shift
+TRAIN_GAMES=${TRAIN_GAMES:-2000}
+FLAGS="-std=c++17 -O2 -flto=auto $CXXFLAGS"
+
+mkdir -p pgo
+rm -f pgo/*.gcda
+echo "Instrumented build"
+$CXX $FLAGS -fprofile-generate -c ThreeMensMorris.cpp -o pgo/ThreeMensMorris.o
+$CXX $FLAGS -fprofile-generate pgo/ThreeMensMorris.o -o pgo/ThreeMensMorris-instrumented $LIBS
+
+echo "Training"
+for board in boards/*.txt; do
+    pgo/ThreeMensMorris-instrumented "$board" --self-play "$TRAIN_GAMES" --seed 1 --headless
+done
+for recording in "$@"; do
+    pgo/ThreeMensMorris-instrumented --play "$recording" --headless
+done
+
+echo "Optimised build: $OUT"
+$CXX $FLAGS -fprofile-use -fprofile-partial-training -c ThreeMensMorris.cpp -o pgo/ThreeMensMorris.o
+$CXX $FLAGS -fprofile-use pgo/ThreeMensMorris.o -o "$OUT" $LIBS
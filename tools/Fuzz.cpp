@@ -0,0 +1,332 @@
+/*
+Fuzz - drives random input through the game state machine and checks its invariants
+
+Build: g++ -std=c++17 -O2 tools/Fuzz.cpp -o Fuzz -lsfml-graphics -lsfml-window -lsfml-system
+Usage: Fuzz [board.txt] [--events N] [--length L] [--seed S]
+       (default boards/three.txt, 10 million events, sequences of 200 steps)
+
+No window is opened: sequences of L steps are fed to handleEvent() and
+updateTokens() of Game.hpp, the code the game runs. A step is a left click
+(on or near a slot, on a button, or anywhere), another mouse or keyboard
+event, an undo or redo key, or a frame of a random length. After every step the state must hold:
+  - tokens: no more per player than placed, exactly as many when mills win,
+    on slots of the board, at most one per slot counting where moving
+    tokens are headed, and the slot masks and slot-to-token index of
+    TokenStore match the tokens;
+  - highlights: the click targets, destinations and hovered slot are what
+    the state and the last pointer position give, and a hint shown is a
+    legal move, or a legal removal;
+  - turns: in placement, Player A moves when both have placed as many
+    tokens; only the player to move has a token selected or moving, and at
+    most one token moves at a time, and a moving token has a tween that
+    will land it;
+  - undo: the steps played in the undo history account for every token
+    placed and removed;
+  - analysis: on a board with a table, the review of a won game is ready
+    on the win screen and replays to the board;
+  - phases: menus hold no tokens, placement ends once every token is
+    placed, movement has every token placed, and a game still in play is
+    not already lost.
+The first failing sequence is shrunk, by dropping steps while the same
+invariant still breaks, and printed with the board. Exits with 0 if every
+sequence passed.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include "../Game.hpp"
+
+// One fuzzer step: an input event, or a frame that moves the tokens
+struct Step {
+    enum Kind : uint8_t { Click, RightClick, Release, MouseMove, Key, Undo, Redo, Frame } kind;
+    float x = 0, y = 0; // Mouse position
+    float dt = 0;       // Frame length in seconds
+};
+
+// Game state as main() keeps it
+struct FuzzGame {
+    TokenStore tokens;
+    Player turn = Player::A;
+    GamePhase phase = GamePhase::Start;
+    int selected = -1;
+    int placedA = 0, placedB = 0;
+    bool removing = false;
+    bool open = true;
+};
+
+std::string describe(const Step& s) {
+    char text[64];
+    switch (s.kind) {
+    case Step::Click: std::snprintf(text, sizeof text, "click %.0f %.0f", s.x, s.y); break;
+    case Step::RightClick: std::snprintf(text, sizeof text, "right click %.0f %.0f", s.x, s.y); break;
+    case Step::Release: std::snprintf(text, sizeof text, "release %.0f %.0f", s.x, s.y); break;
+    case Step::MouseMove: std::snprintf(text, sizeof text, "mouse move %.0f %.0f", s.x, s.y); break;
+    case Step::Key: std::snprintf(text, sizeof text, "key press"); break;
+    case Step::Undo: std::snprintf(text, sizeof text, "undo"); break;
+    case Step::Redo: std::snprintf(text, sizeof text, "redo"); break;
+    case Step::Frame: std::snprintf(text, sizeof text, "frame %.3fs", s.dt); break;
+    }
+    return text;
+}
+
+Step randomStep(std::mt19937& rng) {
+    // Every button position the phases use: start/reset, instructions, about, back, play again, exit, hint
+    static const sf::FloatRect buttons[] = {{165, 440, 275, 100}, {340, 620, 240, 80}, {165, 560, 275, 100},
+                                            {165, 680, 275, 100}, {165, 665, 275, 100}, {165, 510, 275, 100},
+                                            {165, 650, 275, 100}, hintButtonBounds};
+    static const float frames[] = {1.f / 240, 1.f / 60, 0.05f, 0.2f, 1.f};
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    Step s{Step::Click};
+    int roll = static_cast<int>(rng() % 100);
+    if (roll < 55) { // Near a slot: hits the slot, or the token on it
+        sf::Vector2f p = slotPosition(static_cast<int>(rng() % rules.points));
+        s.x = p.x + (unit(rng) - 0.5f) * 60;
+        s.y = p.y + (unit(rng) - 0.5f) * 60;
+    } else if (roll < 65) {
+        const sf::FloatRect& b = buttons[rng() % (sizeof buttons / sizeof buttons[0])];
+        s.x = b.left + unit(rng) * b.width;
+        s.y = b.top + unit(rng) * b.height;
+    } else if (roll < 70) {
+        s.x = unit(rng) * 600;
+        s.y = unit(rng) * 800;
+    } else if (roll < 75) {
+        s.kind = static_cast<Step::Kind>(Step::RightClick + rng() % 4);
+        s.x = unit(rng) * 600;
+        s.y = unit(rng) * 800;
+    } else if (roll < 80) {
+        s.kind = roll < 78 ? Step::Undo : Step::Redo;
+    } else {
+        s.kind = Step::Frame;
+        s.dt = frames[rng() % (sizeof frames / sizeof frames[0])];
+    }
+    return s;
+}
+
+void apply(FuzzGame& g, const Step& s) {
+    if (s.kind == Step::Frame) {
+        updateTokens(g.tokens, s.dt, g.turn, g.selected, g.placedA, g.placedB, g.removing, g.phase);
+        return;
+    }
+    sf::Event ev;
+    if (s.kind == Step::Key || s.kind == Step::Undo || s.kind == Step::Redo) {
+        ev.type = sf::Event::KeyPressed;
+        ev.key.code = s.kind == Step::Undo ? sf::Keyboard::Z : s.kind == Step::Redo ? sf::Keyboard::Y : sf::Keyboard::Space;
+    } else if (s.kind == Step::MouseMove) {
+        ev.type = sf::Event::MouseMoved;
+        ev.mouseMove.x = static_cast<int>(s.x);
+        ev.mouseMove.y = static_cast<int>(s.y);
+    } else {
+        ev.type = s.kind == Step::Release ? sf::Event::MouseButtonReleased : sf::Event::MouseButtonPressed;
+        ev.mouseButton.button = s.kind == Step::RightClick ? sf::Mouse::Right : sf::Mouse::Left;
+        ev.mouseButton.x = static_cast<int>(s.x);
+        ev.mouseButton.y = static_cast<int>(s.y);
+    }
+    g.open = handleEvent(ev, g.tokens, g.turn, g.phase, g.selected, g.placedA, g.placedB, g.removing);
+}
+
+// isGameOver() without generating every move: the side to move has lost, or has nowhere to go
+bool gameOver(const Position32& pos) {
+    if (isLost(rules, pos)) return true;
+    int me = static_cast<int>(pos.turn);
+    if (pos.hand[me] > 0) return (rules.full & ~(pos.men[0] | pos.men[1])) == 0;
+    for (uint32_t m = pos.men[me]; m; m &= m - 1)
+        if (destinations(rules, pos, lowestPoint(m))) return false;
+    return true;
+}
+
+// Name of the first broken invariant, or nullptr
+const char* brokenInvariant(const FuzzGame& g) {
+    const int men = rules.men;
+    int onBoard[2] = {0, 0}, moving = 0, flagged = 0;
+    uint32_t occupied = 0, menOf[2] = {0, 0};
+    for (const auto& t : g.tokens) {
+        int p = static_cast<int>(t.owner);
+        ++onBoard[p];
+        if (t.slotIndex < 0 || t.slotIndex >= rules.points) return "token off the board";
+        if (occupied >> t.slotIndex & 1u) return "two tokens on one slot";
+        if (&g.tokens[g.tokens.bySlot[t.slotIndex]] != &t) return "slot index out of date";
+        occupied |= 1u << t.slotIndex;
+        menOf[p] |= 1u << t.slotIndex;
+        if (t.selected) ++flagged;
+        if (!t.moving) continue;
+        ++moving;
+        if (t.owner != g.turn) return "token of the player not to move is moving";
+    }
+    for (const auto& t : g.tokens)
+        if (t.moving) {
+            if (t.nextSlotIndex < 0 || t.nextSlotIndex >= rules.points) return "token moving off the board";
+            if (occupied >> t.nextSlotIndex & 1u) return "token moving onto an occupied slot";
+            occupied |= 1u << t.nextSlotIndex;
+        }
+    if (occupied != g.tokens.occupied) return "occupancy mask out of date";
+    if (menOf[0] != g.tokens.men[0] || menOf[1] != g.tokens.men[1]) return "slot masks out of date";
+    for (int slot = 0; slot < rules.points; ++slot)
+        if (g.tokens.bySlot[slot] != -1 && !(g.tokens.men[0] >> slot & 1u) && !(g.tokens.men[1] >> slot & 1u))
+            return "slot index out of date";
+    Highlights seen = highlights;
+    refreshHighlights(g.tokens, g.turn, g.phase, g.selected, g.removing);
+    std::swap(seen, highlights);
+    if (seen.targets != highlights.targets || seen.destinations != highlights.destinations || seen.hover != highlights.hover)
+        return "highlights out of date";
+    if (seen.hint.to >= 0 || seen.hint.remove >= 0) {
+        Position32 pos = boardPosition(g.tokens, g.placedA, g.placedB, g.turn);
+        Move moves[kMaxMoves];
+        int n = generateMoves(rules, pos, moves);
+        bool legal = g.removing ? seen.hint.to < 0 && (removableMen(rules, pos.men[1 - static_cast<int>(g.turn)]) >> seen.hint.remove & 1u)
+                                : std::find(moves, moves + n, seen.hint) != moves + n;
+        if (!legal) return "hint is not a legal move";
+    }
+    for (const auto& t : g.tokens)
+        if (t.moving && tweens.find(TweenMove, static_cast<int>(&t - g.tokens.items.data())) == -1)
+            return "token moving without its tween";
+    int placed[2] = {g.placedA, g.placedB};
+    for (int p = 0; p < 2; ++p) {
+        if (placed[p] < 0 || placed[p] > men) return "placed count out of range";
+        if (onBoard[p] > placed[p]) return "more tokens than placed";
+        if (rules.capture == CaptureRule::Win && onBoard[p] != placed[p]) return "token lost without captures";
+    }
+    if (g.placedA != g.placedB && g.placedA != g.placedB + 1) return "placement out of turn";
+    if (moving > 1) return "two tokens moving at once";
+    if (flagged > 1) return "two tokens selected";
+    if (g.selected != -1) {
+        if (!g.tokens.live(g.selected)) return "selected token is not a token";
+        if (g.phase != GamePhase::Movement || g.tokens[g.selected].owner != g.turn) return "token selected out of turn";
+    }
+    if (flagged && (g.selected == -1 || !g.tokens[g.selected].selected)) return "token highlighted but not selected";
+    if (g.removing && rules.capture != CaptureRule::Remove) return "removing without captures";
+    int placements = 0, removals = 0;
+    for (std::size_t i = 0; i < undoHistory.done; ++i) {
+        placements += undoHistory.deltas[i].kind() == GameDelta::Place;
+        removals += undoHistory.deltas[i].kind() == GameDelta::Remove;
+    }
+    if (placements != g.placedA + g.placedB || placements != g.tokens.placed || removals != placements - g.tokens.size())
+        return "undo history out of step";
+
+    switch (g.phase) {
+    case GamePhase::Start:
+    case GamePhase::About:
+    case GamePhase::Instructions:
+        if (!g.tokens.empty() || g.placedA || g.placedB || g.removing) return "tokens left in a menu";
+        break;
+    case GamePhase::Placement:
+        if (g.placedA == men && g.placedB == men && !g.removing) return "placement after every token is placed";
+        if ((g.turn == Player::A) != (g.placedA == g.placedB + (g.removing ? 1 : 0))) return "placement turns do not alternate";
+        break;
+    case GamePhase::Movement:
+        if (g.placedA != men || g.placedB != men) return "movement before every token is placed";
+        break;
+    case GamePhase::Win:
+        if (moving) return "token moving after the game ended";
+        if (analyzeGames) {
+            if (!gameReview.ready || gameReview.review.size() != gameReview.moves.size()) return "analysis not ready on the win screen";
+            Position32 pos = gameReview.start;
+            for (const Move& m : gameReview.moves) pos = applyMove(pos, m);
+            if (pos.men != g.tokens.men) return "analysis reviews another game";
+        }
+        break;
+    }
+    if ((g.phase == GamePhase::Placement || g.phase == GamePhase::Movement) && !g.removing && !moving &&
+        gameOver(boardPosition(g.tokens, g.placedA, g.placedB, g.turn)))
+        return "game in play is already lost";
+    return nullptr;
+}
+
+// Plays a sequence from a fresh game; returns the broken invariant and where, if any
+const char* run(const std::vector<Step>& steps, FuzzGame& g, std::size_t* failedAt = nullptr) {
+    g = FuzzGame();
+    startButtonBounds = sf::FloatRect(165, 440, 275, 100);
+    highlights = Highlights();
+    tweens.clear();
+    undoHistory.clear();
+    hint = Hint();
+    for (std::size_t i = 0; i < steps.size() && g.open; ++i) {
+        apply(g, steps[i]);
+        if (const char* broken = brokenInvariant(g)) {
+            if (failedAt) *failedAt = i;
+            return broken;
+        }
+    }
+    return nullptr;
+}
+
+// Drops chunks of steps, halving the chunk size, while the same invariant still breaks
+std::vector<Step> shrink(std::vector<Step> steps, const char* invariant) {
+    FuzzGame g;
+    std::size_t end = steps.size();
+    if (run(steps, g, &end)) steps.resize(end + 1);
+    for (bool progress = true; progress;) {
+        progress = false;
+        for (std::size_t chunk = std::max<std::size_t>(1, steps.size() / 2); chunk >= 1; chunk /= 2) {
+            for (std::size_t i = 0; i + chunk <= steps.size();) {
+                std::vector<Step> candidate(steps.begin(), steps.begin() + i);
+                candidate.insert(candidate.end(), steps.begin() + i + chunk, steps.end());
+                const char* broken = run(candidate, g, &end);
+                if (broken && !std::strcmp(broken, invariant)) {
+                    candidate.resize(end + 1);
+                    steps = candidate;
+                    progress = true;
+                } else {
+                    i += chunk;
+                }
+            }
+            if (chunk == 1) break;
+        }
+    }
+    return steps;
+}
+
+int main(int argc, char* argv[]) {
+    std::string board = "boards/three.txt";
+    long long events = 10000000;
+    std::size_t length = 200;
+    unsigned seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--events") && i + 1 < argc) events = std::atoll(argv[++i]);
+        else if (!std::strcmp(argv[i], "--length") && i + 1 < argc) length = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--seed") && i + 1 < argc) seed = static_cast<unsigned>(std::atoll(argv[++i]));
+        else if (argv[i][0] != '-') board = argv[i];
+        else {
+            std::fprintf(stderr, "Usage: %s [board.txt] [--events N] [--length L] [--seed S]\n", argv[0]);
+            return 2;
+        }
+    }
+    logFile.close(); // Nothing to log while fuzzing
+    std::string error;
+    if (!loadTopology(board, topology, error) || !compileTopology(topology, rules, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    slotGrid.build(topology, kTokenSize); // As loadBoard() does
+    useTables();
+    analyzeGames = hintFromTable; // Reviews from a table are synchronous; searches would not be
+
+    std::mt19937 rng(seed);
+    std::vector<Step> steps(length);
+    FuzzGame g;
+    long long played = 0, sequences = 0;
+    auto begin = std::chrono::steady_clock::now();
+    while (played < events) {
+        for (auto& s : steps) s = randomStep(rng);
+        const char* broken = run(steps, g);
+        played += static_cast<long long>(steps.size());
+        ++sequences;
+        if (!broken) continue;
+
+        std::vector<Step> small = shrink(steps, broken);
+        std::printf("%s: invariant broken after %lld sequences: %s\n", topology.name.c_str(), sequences, broken);
+        std::printf("Shrunk to %zu steps (seed %u):\n", small.size(), seed);
+        for (const auto& s : small) std::printf("  %s\n", describe(s).c_str());
+        run(small, g);
+        std::printf("Board after the last step:\n%s",
+                    boardDiagram(topology, boardPosition(g.tokens, g.placedA, g.placedB, g.turn)).c_str());
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::printf("%s: %lld events in %lld sequences, %.2fs (%.2f million events/s), no invariant broken\n",
+                topology.name.c_str(), played, sequences, seconds, played / seconds / 1e6);
+    return 0;
+}
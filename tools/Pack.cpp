@@ -0,0 +1,127 @@
+/*
+Pack - packs solved partitions into a block-compressed tablebase
+
+Build: g++ -std=c++17 -O2 -pthread tools/Pack.cpp -o Pack
+Usage: Pack <board.txt> <tables dir> <output.tb> [--block N] [--cache N]
+
+Every partition finished by Solve is packed. Afterwards the tablebase is
+read back and compared with the raw tables, and the compression ratio and
+the probe latency (cold and warm block cache) are reported.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <cstdlib>
+#include <cstring>
+#include "../engine/Tablebase.hpp"
+
+int main(int argc, char* argv[]) {
+    if (argc < 4) {
+        std::fprintf(stderr, "Usage: %s <board.txt> <tables dir> <output.tb> [--block N] [--cache N]\n", argv[0]);
+        return 2;
+    }
+    uint32_t blockSize = 4096;
+    std::size_t cacheBlocks = 64;
+    for (int i = 4; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--block") && i + 1 < argc) blockSize = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--cache") && i + 1 < argc) cacheBlocks = static_cast<std::size_t>(std::atoi(argv[++i]));
+        else {
+            std::fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    Topology topology;
+    Rules32 rules;
+    std::string error;
+    if (!loadTopology(argv[1], topology, error) || !compileTopology(topology, rules, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    SolveProgress progress;
+    if (!progress.load(std::string(argv[2]) + "/progress.txt")) {
+        std::fprintf(stderr, "No solved tables in %s\n", argv[2]);
+        return 1;
+    }
+    std::vector<PartitionKey> keys;
+    for (const auto& group : solveOrder(rules, false))
+        for (const auto& key : group)
+            if (progress.maxDistance.count(key)) keys.push_back(key);
+
+    PositionIndexer<uint32_t> indexer(rules);
+    TableStore<uint32_t> store(rules, indexer, argv[2]);
+    TablebaseStats stats;
+    auto begin = std::chrono::steady_clock::now();
+    if (!writeTablebase(argv[3], topology.name, rules, indexer, store, keys, blockSize, error, stats)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    double packSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::printf("%s: %zu partitions, %llu positions in %llu blocks of %u\n", topology.name.c_str(), keys.size(),
+                static_cast<unsigned long long>(stats.positions), static_cast<unsigned long long>(stats.blocks), blockSize);
+    std::printf("Size: %llu bytes raw, %llu bytes packed (ratio %.2f, %.3f bits per position) in %.2fs\n",
+                static_cast<unsigned long long>(stats.positions), static_cast<unsigned long long>(stats.compressedBytes),
+                double(stats.positions) / stats.compressedBytes, 8.0 * stats.compressedBytes / stats.positions, packSeconds);
+
+    TablebaseFile tb;
+    if (!tb.open(argv[3], error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    // Every block must decode back to the raw values
+    std::vector<uint8_t> block(blockSize);
+    for (const auto& part : tb.partitions()) {
+        const uint8_t* raw = store.values(part.key);
+        for (uint64_t b = 0; b * blockSize < part.positions; ++b) {
+            uint32_t n = tb.blockValues(part, part.firstBlock + b);
+            tb.decode(part.firstBlock + b, n, block.data());
+            if (std::memcmp(block.data(), raw + b * blockSize, n) != 0) {
+                std::fprintf(stderr, "Block %llu of %s does not match the raw table\n",
+                             static_cast<unsigned long long>(b), part.key.name().c_str());
+                return 1;
+            }
+        }
+    }
+    std::printf("Verified: every block matches the raw tables\n");
+
+    // Probe latency on random positions, weighted by partition size
+    std::mt19937_64 rng(42);
+    std::vector<Position32> sample(200000);
+    for (auto& pos : sample) {
+        uint64_t pick = rng() % stats.positions;
+        for (const auto& part : tb.partitions()) {
+            if (pick < part.positions) {
+                pos = partitionPosition(indexer, part.key, pick);
+                break;
+            }
+            pick -= part.positions;
+        }
+    }
+    auto time = [&](std::size_t capacity, bool warmUp, uint64_t& misses) {
+        BlockCache cache(capacity);
+        uint64_t sink = 0;
+        if (warmUp)
+            for (const auto& pos : sample) sink += probeTablebase(tb, cache, rules, indexer, pos);
+        uint64_t missesBefore = cache.misses();
+        auto t0 = std::chrono::steady_clock::now();
+        for (const auto& pos : sample) sink += probeTablebase(tb, cache, rules, indexer, pos);
+        auto t1 = std::chrono::steady_clock::now();
+        misses = cache.misses() - missesBefore + (sink & 0);
+        return std::chrono::duration<double, std::nano>(t1 - t0).count() / double(sample.size());
+    };
+    uint64_t coldMisses = 0, warmMisses = 0;
+    double cold = time(cacheBlocks, false, coldMisses);
+    double warm = time(stats.blocks + 1, true, warmMisses);
+    double raw = [&] {
+        uint64_t sink = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (const auto& pos : sample) sink += store.probe(pos);
+        auto t1 = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(t1 - t0).count() / double(sample.size()) + double(sink & 0);
+    }();
+    std::printf("Probe latency: %.0f ns with a %zu-block cache (%.1f%% misses), %.0f ns with every block cached, %.0f ns raw tables\n",
+                cold, cacheBlocks, 100.0 * coldMisses / sample.size(), warm, raw);
+    return 0;
+}
@@ -0,0 +1,182 @@
+/*
+Puzzles - mines "win in N" puzzles from a tablebase into a puzzle pack for the game
+
+Build: g++ -std=c++17 -O2 -pthread tools/Puzzles.cpp -o Puzzles
+Usage: Puzzles <board.txt> <tablebase.tb> <pack.txt> --win N [--threads N] [--cache N] [--limit K]
+
+Every position of the tablebase is scanned, split across threads a block at a
+time as in Verify. A position is a puzzle when it is a win in N plies (N odd)
+and exactly one of its moves wins at all: the others draw or lose. Its
+children are probed from the tablebase with a block cache of N blocks per
+thread, so only the positions already won in N cost any probes; those whose
+children lie outside the tablebase are skipped, and so are those no game
+reaches because it ended before them (isPastGameEnd()).
+
+Tablebase indices already stand for positions up to the board's symmetries,
+and values are kept for the side to move, so each puzzle is one class of
+positions under symmetry and colour swap. The one exception is the opponent
+tokens of a symmetric side to move: several indices hold images of the same
+position, and only the one index() gives is kept.
+
+The pack is written in file order whatever the thread count, with Player A
+to move unless the position can only arise with Player B to move (B has a
+token more in hand). Load it with: ThreeMensMorris --puzzles <pack.txt>
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include "../engine/Tablebase.hpp"
+
+struct Found {
+    uint64_t where; // Block * block size + offset: the position's place in the file
+    Position32 pos;
+    Move solution;
+};
+
+// The position as the game has it. Player A places first, so a side to move with a
+// token more in hand than the opponent is Player B.
+Position32 gamePosition(const Position32& pos) {
+    if (pos.hand[0] <= pos.hand[1]) return pos;
+    Position32 g;
+    g.men = {pos.men[1], pos.men[0]};
+    g.hand = {pos.hand[1], pos.hand[0]};
+    g.turn = Player::B;
+    return g;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 4) {
+        std::fprintf(stderr, "Usage: %s <board.txt> <tablebase.tb> <pack.txt> --win N [--threads N] [--cache N] [--limit K]\n", argv[0]);
+        return 2;
+    }
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    std::size_t cacheBlocks = 256, limit = SIZE_MAX;
+    int win = -1;
+    for (int i = 4; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--win") && i + 1 < argc) win = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) threads = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--cache") && i + 1 < argc) cacheBlocks = static_cast<std::size_t>(std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--limit") && i + 1 < argc) limit = static_cast<std::size_t>(std::atoll(argv[++i]));
+        else {
+            std::fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (win < 1 || win > kMaxDistance || !isWinValue(static_cast<uint8_t>(win))) {
+        std::fprintf(stderr, "--win needs an odd number of plies, at most %d\n", kMaxDistance);
+        return 2;
+    }
+    threads = std::max(1, threads);
+
+    Topology topology;
+    Rules32 rules;
+    std::string error;
+    if (!loadTopology(argv[1], topology, error) || !compileTopology(topology, rules, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    TablebaseFile tb;
+    if (!tb.open(argv[2], error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    PositionIndexer<uint32_t> indexer(rules);
+    if (tb.points() != rules.points || tb.men() != rules.men || tb.symmetries() != indexer.symmetries()) {
+        std::fprintf(stderr, "%s was not built for %s\n", argv[2], topology.name.c_str());
+        return 1;
+    }
+    // Block number -> partition, for workers that take blocks in file order. A partition
+    // with another size than the indexer gives would send probes outside its blocks.
+    std::vector<const TablebasePartition*> owner;
+    for (const auto& part : tb.partitions())
+        if (part.positions != indexer.size(part.key)) {
+            std::fprintf(stderr, "Partition %s holds %llu positions, the board has %llu\n", part.key.name().c_str(),
+                         static_cast<unsigned long long>(part.positions), static_cast<unsigned long long>(indexer.size(part.key)));
+            return 1;
+        }
+    if (!blockOwners(tb, owner, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    auto seconds = [&] { return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count(); };
+    std::printf("%s: %zu partitions in %llu blocks, %d threads, looking for wins in %d\n", tb.name().c_str(),
+                tb.partitions().size(), static_cast<unsigned long long>(tb.blockCount()), threads, win);
+
+    std::atomic<uint64_t> nextBlock{0}, scanned{0}, candidates{0}, duplicates{0}, unreachable{0}, unknown{0};
+    std::vector<std::vector<Found>> found(threads);
+    runWorkers(threads, [&](int t) {
+        BlockCache cache(cacheBlocks);
+        std::vector<uint8_t> values(tb.blockSize());
+        uint64_t localScanned = 0, localCandidates = 0, localDuplicates = 0, localUnreachable = 0, localUnknown = 0;
+        Move moves[kMaxMoves];
+        for (uint64_t b; (b = nextBlock++) < tb.blockCount();) {
+            const TablebasePartition& part = *owner[b];
+            uint32_t count = tb.blockValues(part, b);
+            tb.decode(b, count, values.data());
+            localScanned += count;
+            for (uint32_t i = 0; i < count; ++i) {
+                if (values[i] != win) continue;
+                ++localCandidates;
+                uint64_t index = (b - part.firstBlock) * tb.blockSize() + i;
+                Position32 pos = partitionPosition(indexer, part.key, index);
+                if (indexer.index(part.key, pos.men[0], pos.men[1]) != index) {
+                    ++localDuplicates;
+                    continue;
+                }
+                if (isPastGameEnd(rules, pos)) {
+                    ++localUnreachable;
+                    continue;
+                }
+                int n = generateMoves(rules, pos, moves), wins = 0;
+                Move solution;
+                bool known = true;
+                for (int m = 0; m < n && known && wins < 2; ++m) {
+                    uint8_t c = probeTablebase(tb, cache, rules, indexer, applyMove(pos, moves[m]));
+                    if (c == kUnknown) known = false;
+                    else if (isLossValue(c)) ++wins, solution = moves[m];
+                }
+                if (!known) ++localUnknown;
+                else if (wins == 1) found[t].push_back({b * tb.blockSize() + i, gamePosition(pos), solution});
+            }
+        }
+        scanned += localScanned;
+        candidates += localCandidates;
+        duplicates += localDuplicates;
+        unreachable += localUnreachable;
+        unknown += localUnknown;
+    });
+    double scanSeconds = seconds();
+
+    std::vector<Found> puzzles;
+    for (auto& f : found) puzzles.insert(puzzles.end(), f.begin(), f.end());
+    std::sort(puzzles.begin(), puzzles.end(), [](const Found& x, const Found& y) { return x.where < y.where; });
+    std::printf("[%6.1fs] Scanned %llu positions (%.1f M/s): %llu wins in %d, %llu symmetric duplicates, "
+                "%llu the game cannot reach, %llu with children outside the tablebase, %zu with a single winning move\n",
+                scanSeconds, static_cast<unsigned long long>(scanned.load()), scanned / scanSeconds / 1e6,
+                static_cast<unsigned long long>(candidates.load()), win, static_cast<unsigned long long>(duplicates.load()),
+                static_cast<unsigned long long>(unreachable.load()), static_cast<unsigned long long>(unknown.load()), puzzles.size());
+    if (puzzles.size() > limit) puzzles.resize(limit);
+
+    std::ofstream out(argv[3]);
+    out << "# " << topology.name << " puzzles: win in " << win << " plies, with a single winning move\n";
+    out << "# puzzle <turn> <men A> <men B> <hand A> <hand B> <value> <solution>, men as hex slot masks\n";
+    out << "board " << argv[1] << "\n";
+    out << std::hex;
+    for (const Found& f : puzzles)
+        out << "puzzle " << (f.pos.turn == Player::A ? 'A' : 'B') << ' ' << f.pos.men[0] << ' ' << f.pos.men[1]
+            << std::dec << ' ' << f.pos.hand[0] << ' ' << f.pos.hand[1] << ' ' << win << ' '
+            << moveName(f.solution) << std::hex << '\n';
+    out.close();
+    if (!out) {
+        std::fprintf(stderr, "Cannot write %s\n", argv[3]);
+        return 1;
+    }
+    std::printf("Wrote %zu puzzles to %s\n", puzzles.size(), argv[3]);
+    return 0;
+}
@@ -0,0 +1,133 @@
+/*
+Solve - builds the perfect play tables of a Morris board
+
+Build: g++ -std=c++17 -O2 -pthread tools/Solve.cpp -o Solve
+Usage: Solve <board.txt> <output dir> [--threads N] [--movement-only] [--in-memory | --bitsliced]
+             [--processes P --memory MB]
+
+Partitions are written to the output directory as they are solved. Running
+the same command again after an interruption resumes from progress.txt.
+With --in-memory, movement groups are solved by backward propagation
+(ParallelRetrograde.hpp) instead of layer by layer; with --bitsliced, their
+layers are run on bitmaps, 64 positions at a time (BitslicedRetrograde.hpp).
+Both keep the group in RAM.
+
+With --processes, the solve is split into shards run by up to P worker
+processes, each sized to fit in MB megabytes (Sharding.hpp). --threads is
+then the number of threads of each worker. Workers are this program started
+with --shard, which is not meant to be used by hand.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "../engine/Sharding.hpp"
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::fprintf(stderr,
+                     "Usage: %s <board.txt> <output dir> [--threads N] [--movement-only] [--in-memory | --bitsliced]\n"
+                     "       [--processes P --memory MB]\n",
+                     argv[0]);
+        return 2;
+    }
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    int processes = 0;
+    uint64_t memoryMB = 1024;
+    bool movementOnly = false, threadsGiven = false;
+    CyclicMethod method = CyclicMethod::Layered;
+    Shard shard;
+    for (int i = 3; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) threads = std::atoi(argv[++i]), threadsGiven = true;
+        else if (!std::strcmp(argv[i], "--movement-only")) movementOnly = true;
+        else if (!std::strcmp(argv[i], "--in-memory")) method = CyclicMethod::Backward;
+        else if (!std::strcmp(argv[i], "--bitsliced")) method = CyclicMethod::Bitsliced;
+        else if (!std::strcmp(argv[i], "--processes") && i + 1 < argc) processes = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--memory") && i + 1 < argc) memoryMB = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--shard") && i + 6 < argc) {
+            // --shard <stmMen> <stmHand> <oppMen> <oppHand> <begin> <end>, or "cyclic" for the range
+            PartitionKey key{std::atoi(argv[i + 1]), std::atoi(argv[i + 2]), std::atoi(argv[i + 3]), std::atoi(argv[i + 4])};
+            shard.group = {key};
+            shard.cyclic = !std::strcmp(argv[i + 5], "cyclic");
+            shard.begin = std::strtoull(argv[i + 5], nullptr, 10);
+            shard.end = std::strtoull(argv[i + 6], nullptr, 10);
+            i += 6;
+        } else {
+            std::fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    Topology topology;
+    Rules32 rules;
+    std::string error;
+    if (!loadTopology(argv[1], topology, error) || !compileTopology(topology, rules, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    PositionIndexer<uint32_t> indexer(rules);
+
+    if (!shard.group.empty()) { // Worker: the group is the one of solveOrder() holding the key
+        for (const auto& group : solveOrder(rules, false))
+            if (std::find(group.begin(), group.end(), shard.group[0]) != group.end()) shard.group = group;
+        if (!runShard(rules, indexer, argv[2], shard, method, threads, error)) {
+            std::fprintf(stderr, "Shard %s failed: %s\n", shard.group[0].name().c_str(), error.c_str());
+            return 1;
+        }
+        return 0;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    auto report = [&](const std::string& message) {
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        std::printf("[%8.1fs] %s\n", s, message.c_str());
+        std::fflush(stdout);
+    };
+    report("Indexing with " + std::to_string(indexer.symmetries()) + " board symmetries");
+
+    if (processes > 0) {
+        if (!threadsGiven) threads = std::max(1, threads / processes);
+        report("Solving " + topology.name + " with " + std::to_string(processes) + " processes of " +
+               std::to_string(threads) + " threads, " + std::to_string(memoryMB) + " MB each");
+        const char* flag = method == CyclicMethod::Backward ? "--in-memory" : method == CyclicMethod::Bitsliced ? "--bitsliced" : "";
+        auto workerArgs = [&](const Shard& s) {
+            const PartitionKey& k = s.group[0];
+            std::vector<std::string> args = {argv[0], argv[1], argv[2], "--threads", std::to_string(threads), "--shard",
+                                             std::to_string(k.stmMen), std::to_string(k.stmHand), std::to_string(k.oppMen),
+                                             std::to_string(k.oppHand), s.cyclic ? "cyclic" : std::to_string(s.begin),
+                                             std::to_string(s.end)};
+            if (*flag) args.push_back(flag);
+            return args;
+        };
+        ShardedSolve<uint32_t> sharded(rules, indexer, argv[2], processes, memoryMB << 20, method);
+        if (!sharded.solve(movementOnly, workerArgs, error, report)) {
+            std::fprintf(stderr, "Solve failed: %s\n", error.c_str());
+            return 1;
+        }
+    } else {
+        report("Solving " + topology.name + " with " + std::to_string(threads) + " threads");
+    }
+
+    RetrogradeSolver<uint32_t> solver(rules, indexer, argv[2], threads);
+    ParallelRetrograde<uint32_t> backward(rules, indexer, solver.store(), threads);
+    if (method == CyclicMethod::Backward)
+        solver.setCyclicSolver([&](const std::vector<PartitionKey>& group, const std::vector<uint8_t*>& values,
+                                   std::string& err) { return backward.solve(group, values, err); });
+    BitslicedRetrograde<uint32_t> sliced(rules, indexer, solver.store(), threads);
+    if (method == CyclicMethod::Bitsliced)
+        solver.setCyclicSolver([&](const std::vector<PartitionKey>& group, const std::vector<uint8_t*>& values,
+                                   std::string& err) { return sliced.solve(group, values, err); });
+    if (processes == 0 && !solver.solve(movementOnly, error, report)) {
+        std::fprintf(stderr, "Solve failed: %s\n", error.c_str());
+        return 1;
+    }
+
+    if (!movementOnly) {
+        uint8_t v = solver.store().probe(startPosition(rules));
+        std::string result = v == kDraw ? "a draw" : isWinValue(v) ? "a win for Player A" : "a win for Player B";
+        report("Start position is " + result + (v == kDraw ? "" : " in " + std::to_string(v) + " plies"));
+    }
+    return 0;
+}
@@ -0,0 +1,168 @@
+/*
+Verify - checks a tablebase for corruption and for values that contradict the rules
+
+Build: g++ -std=c++17 -O2 -pthread tools/Verify.cpp -o Verify
+Usage: Verify <board.txt> <tablebase.tb> [--threads N] [--cache N]
+
+The tablebase is memory mapped (TablebaseFile::open() rejects a partition
+table or offset index that points outside the file). Each partition must hold
+as many positions as the board has, and each block must belong to exactly one
+partition. Then the tablebase is checked in two passes, both split across
+threads a block at a time:
+  1. the CRC-32 of every compressed block;
+  2. every position against its children, probed from the tablebase itself
+     with a block cache of N blocks per thread: a win in d has a child lost
+     in d - 1 and none lost sooner, a loss in d has only children won in at
+     most d - 1 plies, a draw has no lost child but some drawn one.
+Positions whose children lie in partitions the tablebase does not hold (a
+movement-only tablebase, for one) are counted but cannot be checked. The
+first inconsistency in file order is printed with a diagram of the board.
+Exits with 0 if the tablebase is sound, 1 otherwise.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include "../engine/Tablebase.hpp"
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::fprintf(stderr, "Usage: %s <board.txt> <tablebase.tb> [--threads N] [--cache N]\n", argv[0]);
+        return 2;
+    }
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    std::size_t cacheBlocks = 256;
+    for (int i = 3; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) threads = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--cache") && i + 1 < argc) cacheBlocks = static_cast<std::size_t>(std::atoi(argv[++i]));
+        else {
+            std::fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    threads = std::max(1, threads);
+
+    Topology topology;
+    Rules32 rules;
+    std::string error;
+    if (!loadTopology(argv[1], topology, error) || !compileTopology(topology, rules, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    TablebaseFile tb;
+    if (!tb.open(argv[2], error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    PositionIndexer<uint32_t> indexer(rules);
+    if (tb.points() != rules.points || tb.men() != rules.men || tb.symmetries() != indexer.symmetries()) {
+        std::fprintf(stderr, "%s was not built for %s\n", argv[2], topology.name.c_str());
+        return 1;
+    }
+    // Block number -> partition, for workers that take blocks in file order. A partition
+    // with another size than the indexer gives would send probes outside its blocks.
+    std::vector<const TablebasePartition*> owner;
+    for (const auto& part : tb.partitions())
+        if (part.positions != indexer.size(part.key)) {
+            std::printf("Partition %s holds %llu positions, the board has %llu\n", part.key.name().c_str(),
+                        static_cast<unsigned long long>(part.positions), static_cast<unsigned long long>(indexer.size(part.key)));
+            return 1;
+        }
+    if (!blockOwners(tb, owner, error)) {
+        std::printf("%s\n", error.c_str());
+        return 1;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    auto seconds = [&] { return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count(); };
+    std::printf("%s: %zu partitions in %llu blocks, %d threads\n", tb.name().c_str(), tb.partitions().size(),
+                static_cast<unsigned long long>(tb.blockCount()), threads);
+
+    // 1. Block checksums
+    std::atomic<uint64_t> nextBlock{0}, badBlocks{0}, firstBadBlock{UINT64_MAX};
+    runWorkers(threads, [&](int) {
+        for (uint64_t b; (b = nextBlock++) < tb.blockCount();)
+            if (!tb.blockIntact(b)) {
+                ++badBlocks;
+                for (uint64_t seen = firstBadBlock; b < seen && !firstBadBlock.compare_exchange_weak(seen, b);) {}
+            }
+    });
+    if (badBlocks) {
+        uint64_t b = firstBadBlock;
+        std::printf("CRC mismatch in %llu block%s, the first is block %llu (%s, positions %llu+)\n",
+                    static_cast<unsigned long long>(badBlocks.load()), badBlocks == 1 ? "" : "s",
+                    static_cast<unsigned long long>(b),
+                    owner[b]->key.name().c_str(), static_cast<unsigned long long>((b - owner[b]->firstBlock) * tb.blockSize()));
+        return 1;
+    }
+    std::printf("[%6.1fs] Checksums: all %llu blocks intact\n", seconds(), static_cast<unsigned long long>(tb.blockCount()));
+
+    // 2. Every value against its children. The first failure in file order is kept.
+    std::atomic<uint64_t> checked{0}, unverifiable{0}, failures{0}, first{UINT64_MAX};
+    std::mutex reportMutex;
+    std::string firstReport;
+    nextBlock = 0;
+    runWorkers(threads, [&](int) {
+        BlockCache cache(cacheBlocks);
+        std::vector<uint8_t> values(tb.blockSize());
+        uint64_t localChecked = 0, localUnverifiable = 0;
+        Move moves[kMaxMoves];
+        for (uint64_t b; (b = nextBlock++) < tb.blockCount();) {
+            if (b * tb.blockSize() > first) break; // Past the first failure already found
+            const TablebasePartition& part = *owner[b];
+            uint32_t count = tb.blockValues(part, b);
+            tb.decode(b, count, values.data());
+            for (uint32_t i = 0; i < count; ++i) {
+                uint64_t index = (b - part.firstBlock) * tb.blockSize() + i;
+                Position32 pos = partitionPosition(indexer, part.key, index);
+                uint8_t v = values[i];
+                bool lost = isLost(rules, pos);
+                ChildSummary s;
+                bool known = true;
+                if (!lost) {
+                    s.children = generateMoves(rules, pos, moves);
+                    for (int m = 0; m < s.children && known; ++m) {
+                        uint8_t c = probeTablebase(tb, cache, rules, indexer, applyMove(pos, moves[m]));
+                        if (c == kUnknown) known = false;
+                        else if (isLossValue(c)) s.minLoss = std::min(s.minLoss, c);
+                        else if (isWinValue(c)) s.maxWin = std::max(s.maxWin, c);
+                        else s.undecided = true;
+                    }
+                }
+                if (!known && v != kUnknown) {
+                    ++localUnverifiable;
+                    continue;
+                }
+                ++localChecked;
+                if (v != kUnknown && consistentValue(lost, s, v)) continue;
+
+                ++failures;
+                uint64_t where = b * tb.blockSize() + i;
+                std::lock_guard<std::mutex> lock(reportMutex);
+                if (where >= first) continue;
+                first = where;
+                firstReport = part.key.name() + " index " + std::to_string(index) + " holds " + valueName(v) + ", but ";
+                if (lost || s.children == 0) firstReport += "the side to move has already lost";
+                else
+                    firstReport += std::to_string(s.children) + " children give: shortest loss " +
+                                   (s.minLoss == kUnknown ? std::string("none") : std::to_string(s.minLoss)) +
+                                   ", longest win " + std::to_string(s.maxWin) + (s.undecided ? ", some draws" : "");
+                firstReport += "\n" + boardDiagram(topology, pos);
+            }
+        }
+        checked += localChecked;
+        unverifiable += localUnverifiable;
+    });
+
+    if (failures) {
+        std::printf("Inconsistent values found; the first in file order is\n  %s", firstReport.c_str());
+        return 1;
+    }
+    std::printf("[%6.1fs] Consistency: %llu positions agree with their children", seconds(),
+                static_cast<unsigned long long>(checked.load()));
+    if (unverifiable) std::printf(", %llu have children outside the tablebase", static_cast<unsigned long long>(unverifiable.load()));
+    std::printf("\n");
+    return 0;
+}